@@ -0,0 +1,76 @@
+#include "AllocationCounter.h"
+
+#include <stdlib.h>
+#include <new>
+
+// Kept apart from the benchmarks, so the replaced new and delete are never inlined where they are used
+// Until -bench starts counting, and in every other run of the game, they go straight to malloc and free
+static bool count_allocations = false;
+static thread_local uint64 allocations = 0;
+
+void* operator new(size_t size)
+{
+	if (count_allocations) allocations++;
+
+	void* block = malloc(size > 0 ? size : 1);
+	if (block == NULL) throw std::bad_alloc();
+
+	return block;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	if (count_allocations) allocations++;
+	return malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+// Every form frees through the plain one, as every form of new allocates like the plain one
+void operator delete(void* block) noexcept
+{
+	free(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+	operator delete(block);
+}
+
+void operator delete(void* block, size_t) noexcept
+{
+	operator delete(block);
+}
+
+void operator delete[](void* block, size_t) noexcept
+{
+	operator delete(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept
+{
+	operator delete(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept
+{
+	operator delete(block);
+}
+
+void StartCountingAllocations()
+{
+	count_allocations = true;
+}
+
+uint64 GetAllocationCount()
+{
+	return allocations;
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "Globals.h"
+
+// Heap allocations made through new by the calling thread, for the benchmarks
+// Box2D allocates through b2Alloc, counted apart by b2GetAllocCount()
+void StartCountingAllocations();
+uint64 GetAllocationCount();
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "Animations.h"
+#include "ModuleAssets.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+bool Animations::LoadClips(const char* path)
+{
+	FILE* file = NULL;
+
+	if (fopen_s(&file, path, "r") != 0 || file == NULL)
+	{
+		LOG("Cannot open animation clips: %s", path);
+		return false;
+	}
+
+	// Next clips can be defined further down the file, they are resolved at the end
+	std::vector<std::string> next_names;
+
+	char line[256];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		char first[32];
+		char value[128];
+		char third[32];
+		char fourth[32];
+		char fifth[ANIMATION_NAME_SIZE];
+
+		const char* cursor = line;
+		int read = 0;
+		read += ReadToken(cursor, first, sizeof(first));
+		read += ReadToken(cursor, value, sizeof(value));
+		read += ReadToken(cursor, third, sizeof(third));
+		read += ReadToken(cursor, fourth, sizeof(fourth));
+		read += ReadToken(cursor, fifth, sizeof(fifth));
+
+		if (read == 0 || first[0] == '#') continue;
+
+		if (strcmp(first, "clip") == 0 && read >= 4)
+		{
+			AnimationClip clip = {};
+			snprintf(clip.name, sizeof(clip.name), "%s", value);
+			clip.first_frame = (uint)frames.size();
+			clip.frame_time = strtof(third, NULL);
+			clip.mode = (strcmp(fourth, "pingpong") == 0) ? ANIMATION_PING_PONG : (strcmp(fourth, "once") == 0) ? ANIMATION_ONCE : ANIMATION_LOOP;
+			clip.next_clip = -1;
+
+			clips.push_back(clip);
+			next_names.push_back(fifth);
+		}
+		else if (strcmp(first, "frame") == 0 && read >= 2 && !clips.empty())
+		{
+			frame_paths.push_back(value);
+			frame_scales.push_back((read >= 3) ? atoi(third) : 0);
+			frames.push_back(Sprite());
+			clips.back().frame_count++;
+		}
+		else
+		{
+			LOG("Ignoring bad animation line: %s", line);
+		}
+	}
+
+	fclose(file);
+
+	for (uint i = 0; i < clips.size(); ++i)
+	{
+		if (!next_names[i].empty()) clips[i].next_clip = FindClip(next_names[i].c_str());
+	}
+
+	return true;
+}
+
+// The sprites are written by the loader, frames must not grow after this
+void Animations::QueueFrames(ModuleAssets* assets)
+{
+	for (uint i = 0; i < frames.size(); ++i)
+	{
+		if (frame_scales[i] == 0) assets->AddSprite(frame_paths[i].c_str(), &frames[i]);
+		else assets->QueueSprite(frame_paths[i].c_str(), &frames[i], ASSET_DEFERRED, frame_scales[i]);
+	}
+}
+
+int Animations::FindClip(const char* name) const
+{
+	for (uint i = 0; i < clips.size(); ++i)
+	{
+		if (strcmp(clips[i].name, name) == 0) return (int)i;
+	}
+
+	LOG("Unknown animation clip: %s", name);
+	return -1;
+}
+
+uint Animations::Add(int clip)
+{
+	uint animation = (uint)timers.size();
+
+	timers.push_back(0.0f);
+	frame_times.push_back(0.0f);
+	current_frames.push_back(0);
+	clip_ids.push_back(-1);
+	directions.push_back(1);
+
+	Play(animation, clip, true);
+
+	return animation;
+}
+
+void Animations::Play(uint animation, int clip, bool restart)
+{
+	if (clip_ids[animation] == clip && !restart) return;
+
+	bool valid = (clip >= 0 && clip < (int)clips.size());
+
+	timers[animation] = 0.0f;
+	frame_times[animation] = valid ? clips[clip].frame_time : 0.0f;
+	current_frames[animation] = valid ? clips[clip].first_frame : 0;
+	clip_ids[animation] = valid ? clip : -1;
+	directions[animation] = 1;
+}
+
+// Only the timers are touched every frame, clips are looked up when an animation changes frame
+void Animations::Advance(float dt)
+{
+	uint count = (uint)timers.size();
+	float* timer = timers.data();
+	const float* frame_time = frame_times.data();
+
+	for (uint i = 0; i < count; ++i)
+	{
+		timer[i] += dt;
+		if (timer[i] >= frame_time[i]) NextFrame(i);
+	}
+}
+
+void Animations::NextFrame(uint animation)
+{
+	timers[animation] = 0.0f;
+	if (clip_ids[animation] < 0) return;
+
+	const AnimationClip& clip = clips[clip_ids[animation]];
+	if (clip.frame_count == 0) return;
+
+	int last = (int)clip.frame_count - 1;
+	int position = (int)(current_frames[animation] - clip.first_frame) + directions[animation];
+
+	if (position < 0 || position > last)
+	{
+		switch (clip.mode)
+		{
+		case ANIMATION_LOOP:
+			position = 0;
+			break;
+
+		case ANIMATION_PING_PONG:
+			directions[animation] = -directions[animation];
+			position = MAX(0, MIN(position + directions[animation] * 2, last));
+			break;
+
+		case ANIMATION_ONCE:
+			if (clip.next_clip >= 0)
+			{
+				Play(animation, clip.next_clip, true);
+				return;
+			}
+			position = last;
+			break;
+		}
+	}
+
+	current_frames[animation] = clip.first_frame + position;
+}
+
+const Sprite& Animations::GetFrame(uint animation) const
+{
+	if (clip_ids[animation] < 0 || current_frames[animation] >= frames.size()) return empty;
+
+	return frames[current_frames[animation]];
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Globals.h"
+#include "ModuleRender.h"
+
+#include <string>
+#include <vector>
+
+#define ANIMATION_NAME_SIZE 32
+
+class ModuleAssets;
+
+enum AnimationMode
+{
+	ANIMATION_LOOP,
+	ANIMATION_PING_PONG,	// Walks back from the last frame to the first
+	ANIMATION_ONCE			// Plays the next clip when done, or holds the last frame
+};
+
+// Frames [first_frame, first_frame + frame_count) of Animations::frames
+struct AnimationClip
+{
+	char name[ANIMATION_NAME_SIZE];
+	uint first_frame;
+	uint frame_count;
+	float frame_time;
+	AnimationMode mode;
+	int next_clip;
+};
+
+// Every playing animation, kept in parallel arrays so Advance() walks them all in one pass
+// Clips are read from a text file, see Assets/Ruby/animations.txt for the format
+class Animations
+{
+public:
+
+	bool LoadClips(const char* path);
+	// Frames are empty sprites until the assets are uploaded
+	void QueueFrames(ModuleAssets* assets);
+
+	int FindClip(const char* name) const;
+
+	uint Add(int clip);
+	void Play(uint animation, int clip, bool restart = false);
+	void Advance(float dt);
+
+	const Sprite& GetFrame(uint animation) const;
+
+private:
+
+	void NextFrame(uint animation);
+
+	std::vector<AnimationClip> clips;
+	std::vector<Sprite> frames;
+	std::vector<std::string> frame_paths;
+	std::vector<int> frame_scales;
+
+	// One entry per animation
+	std::vector<float> timers;
+	std::vector<float> frame_times;
+	std::vector<uint> current_frames;	// Index into frames
+	std::vector<int> clip_ids;
+	std::vector<int> directions;		// 1 or -1, only ping-pong clips go backwards
+
+	Sprite empty;
+};
\ No newline at end of file
@@ -1,6 +1,8 @@
 
 #include "Module.h"
 #include "ModuleWindow.h"
+#include "ModuleInput.h"
+#include "ModuleAssets.h"
 #include "ModuleRender.h"
 #include "ModuleAudio.h"
 #include "ModulePhysics.h"
@@ -8,11 +10,20 @@
 
 #include "Application.h"
 
-Application::Application()
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+Application::Application(int argc, char** argv)
 {
-	window = new ModuleWindow(this);
-	renderer = new ModuleRender(this);
-	audio = new ModuleAudio(this, true);
+	ParseArguments(argc, argv);
+
+	// Headless runs keep these modules disabled, so they never touch the window, GPU or audio device
+	window = new ModuleWindow(this, !headless);
+	input = new ModuleInput(this);
+	assets = new ModuleAssets(this, !headless);
+	renderer = new ModuleRender(this, !headless);
+	audio = new ModuleAudio(this, !headless);
 	physics = new ModulePhysics(this);
 	scene_intro = new ModuleGame(this);
 
@@ -21,19 +32,24 @@ Application::Application()
 	// They will CleanUp() in reverse order
 
 	// Main Modules
-	AddModule(window);
-	AddModule(physics);
-	AddModule(audio);
+	AddModule(window, "Window");
+	AddModule(input, "Input");
+	AddModule(assets, "Assets");
+	AddModule(physics, "Physics", true);
+	AddModule(audio, "Audio", true);
 	
 	// Scenes
-	AddModule(scene_intro);
+	AddModule(scene_intro, "Game", true);
 
 	// Rendering happens at the end
-	AddModule(renderer);
+	AddModule(renderer, "Render");
 }
 
 Application::~Application()
 {
+	// Paths that skip CleanUp() must not delete the modules under a running tick
+	StopSimulationThread();
+
 	for (auto it = list_modules.rbegin(); it != list_modules.rend(); ++it)
 	{
 		Module* item = *it;
@@ -47,58 +63,106 @@ bool Application::Init()
 {
 	bool ret = true;
 
-	// Call Init() in all modules
+	// Before the modules start, the replay sets the ball count they start with
+	if (replay_file != NULL)
+	{
+		ret = input->LoadReplay(replay_file);
+	}
+
+	// Call Init() in all enabled modules
 	for (auto it = list_modules.begin(); it != list_modules.end() && ret; ++it)
 	{
 		Module* module = *it;
-		ret = module->Init();
+		if (module->IsEnabled())
+		{
+			ret = module->Init();
+		}
 	}
 
-	// After all Init calls we call Start() in all modules
+	// After all Init calls we call Start() in all enabled modules
 	LOG("Application Start --------------");
 
 	for (auto it = list_modules.begin(); it != list_modules.end() && ret; ++it)
 	{
 		Module* module = *it;
-		ret = module->Start();
+		if (module->IsEnabled())
+		{
+			ret = module->Start();
+		}
+	}
+
+	if (ret && input_script != NULL)
+	{
+		ret = input->LoadScript(input_script);
+	}
+
+	if (ret && replay_file == NULL && record_file != NULL)
+	{
+		input->StartRecording();
 	}
+
+	if (ret && pipelined)
+	{
+		simulation_thread = std::thread(&Application::SimulationThread, this);
+	}
+
+	run_time.Start();
 	
 	return ret;
 }
 
 // Call PreUpdate, Update and PostUpdate on all modules
+// The simulation modules record their drawing into a render snapshot that the renderer presents next
 update_status Application::Update()
 {
 	update_status ret = UPDATE_CONTINUE;
 
-	for (auto it = list_modules.begin(); it != list_modules.end() && ret == UPDATE_CONTINUE; ++it)
+	// Every call is timed so the profiler can attribute the frame to each module
+	frame_time.Start();
+	profiler.BeginFrame();
+	std::fill(frame_samples.begin(), frame_samples.end(), 0.0f);
+
+	// The last tick has to be finished before the input of the next one is polled
+	if (pipelined) ret = WaitSimulation();
+
+	// Headless runs have no frame time and step once per frame, as fast as the CPU allows
+	dt = headless ? PHYSICS_TIMESTEP : GetFrameTime();
+
+	if (ret == UPDATE_CONTINUE) ret = CallModules(frame_modules, PROFILE_PRE_UPDATE, frame_samples);
+
+	// Nothing is simulated until the assets needed for the first frame are uploaded
+	if (ret == UPDATE_CONTINUE && !assets->IsReady())
 	{
-		Module* module = *it;
-		if (module->IsEnabled())
-		{
-			ret = module->PreUpdate();
-		}
+		renderer->SwapSnapshots();
 	}
-
-	for (auto it = list_modules.begin(); it != list_modules.end() && ret == UPDATE_CONTINUE; ++it)
+	else if (ret == UPDATE_CONTINUE)
 	{
-		Module* module = *it;
-		if (module->IsEnabled())
+		if (pipelined)
 		{
-			ret = module->Update();
+			// Draw tick N while tick N+1 is simulated, at the cost of one frame of latency
+			renderer->SwapSnapshots();
+			StartSimulation();
 		}
-	}
-
-	for (auto it = list_modules.begin(); it != list_modules.end() && ret == UPDATE_CONTINUE; ++it)
-	{
-		Module* module = *it;
-		if (module->IsEnabled())
+		else
 		{
-			ret = module->PostUpdate();
+			ret = Simulate();
+			RecordSamples(simulation_modules, simulation_samples);
+			renderer->SwapSnapshots();
 		}
 	}
 
-	if (WindowShouldClose()) ret = UPDATE_STOP;
+	if (ret == UPDATE_CONTINUE) ret = CallModules(frame_modules, PROFILE_UPDATE, frame_samples);
+	if (ret == UPDATE_CONTINUE) ret = CallModules(frame_modules, PROFILE_POST_UPDATE, frame_samples);
+
+	RecordSamples(frame_modules, frame_samples);
+	profiler.SetFrameTime((float)frame_time.ReadMs());
+	profiler.EndFrame();
+
+	// A frame stopped early by a module did not run a full tick
+	if (ret == UPDATE_CONTINUE) frame_count++;
+
+	if (max_frames > 0 && frame_count >= max_frames) ret = UPDATE_STOP;
+	if (!headless && WindowShouldClose()) ret = UPDATE_STOP;
 
 	return ret;
 }
@@ -106,16 +170,217 @@ update_status Application::Update()
 bool Application::CleanUp()
 {
 	bool ret = true;
+
+	StopSimulationThread();
+
+	if (record_file != NULL && !input->IsReplaying())
+	{
+		input->SaveReplay(record_file, physics->GetStateHash());
+		printf("Recorded %u ticks to %s\n", input->GetReplayTicks(), record_file);
+	}
+
+	if (replay_file != NULL && input->IsReplaying())
+	{
+		uint32 state_hash = physics->GetStateHash();
+
+		if (!input->ReplayFinished()) printf("Replay stopped after %u ticks\n", input->GetReplayTicks());
+		else if (state_hash == input->GetReplayHash()) printf("Replay matches its recording (state %08x)\n", state_hash);
+		else printf("Replay diverged: state %08x, recorded %08x\n", state_hash, input->GetReplayHash());
+	}
+
 	for (auto it = list_modules.rbegin(); it != list_modules.rend() && ret; ++it)
 	{
 		Module* item = *it;
-		ret = item->CleanUp();
+		if (item->IsEnabled())
+		{
+			ret = item->CleanUp();
+		}
+	}
+
+	if (headless && !quiet)
+	{
+		// One physics step per frame when headless
+		double seconds = run_time.ReadSec();
+		printf("Headless run: %llu steps in %.3f s (%.0f steps/sec)\n", (unsigned long long)frame_count, seconds, (seconds > 0.0) ? frame_count / seconds : 0.0);
+	}
+
+	if (profile_csv != NULL)
+	{
+		profiler.SaveCSV(profile_csv);
 	}
 	
 	return ret;
 }
 
-void Application::AddModule(Module* mod)
+void Application::ParseArguments(int argc, char** argv)
 {
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-headless") == 0)
+		{
+			headless = true;
+		}
+		else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+		{
+			max_frames = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-input") == 0 && i + 1 < argc)
+		{
+			input_script = argv[++i];
+		}
+		else if (strcmp(argv[i], "-profile") == 0 && i + 1 < argc)
+		{
+			profile_csv = argv[++i];
+		}
+		else if (strcmp(argv[i], "-pipelined") == 0)
+		{
+			pipelined = true;
+		}
+		else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+		{
+			record_file = argv[++i];
+		}
+		else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+		{
+			replay_file = argv[++i];
+		}
+		else if (strcmp(argv[i], "-table") == 0 && i + 1 < argc)
+		{
+			table_file = argv[++i];
+		}
+		else if (strcmp(argv[i], "-balls") == 0 && i + 1 < argc)
+		{
+			ball_count = (uint)strtoul(argv[++i], NULL, 10);
+			if (ball_count == 0) ball_count = 1;
+		}
+		else if (strcmp(argv[i], "-physics-threads") == 0 && i + 1 < argc)
+		{
+			physics_threads = (uint)strtoul(argv[++i], NULL, 10);
+			if (physics_threads == 0) physics_threads = 1;
+		}
+		else
+		{
+			LOG("Unknown argument: %s", argv[i]);
+		}
+	}
+
+	// Headless runs need an end, replays stop by themselves when they run out of ticks
+	if (headless && max_frames == 0 && replay_file == NULL) max_frames = HEADLESS_DEFAULT_FRAMES;
+
+	// Nothing is drawn when headless, so there is nothing to overlap the simulation with
+	if (headless) pipelined = false;
+}
+
+void Application::AddModule(Module* mod, const char* name, bool simulation)
+{
+	uint index = (uint)list_modules.size();
 	list_modules.emplace_back(mod);
+
+	if (simulation) simulation_modules.push_back(index);
+	else frame_modules.push_back(index);
+
+	profiler.AddTrack(name);
+	frame_samples.resize(list_modules.size() * PROFILE_PHASE_COUNT, 0.0f);
+	simulation_samples.resize(list_modules.size() * PROFILE_PHASE_COUNT, 0.0f);
+}
+
+update_status Application::CallModules(const std::vector<uint>& modules, ProfilerPhase phase, std::vector<float>& samples)
+{
+	update_status ret = UPDATE_CONTINUE;
+	PerfTimer timer;
+
+	for (uint i = 0; i < modules.size() && ret == UPDATE_CONTINUE; ++i)
+	{
+		Module* module = list_modules[modules[i]];
+		if (module->IsEnabled())
+		{
+			timer.Start();
+
+			switch (phase)
+			{
+			case PROFILE_PRE_UPDATE: ret = module->PreUpdate(); break;
+			case PROFILE_UPDATE: ret = module->Update(); break;
+			case PROFILE_POST_UPDATE: ret = module->PostUpdate(); break;
+			default: break;
+			}
+
+			samples[modules[i] * PROFILE_PHASE_COUNT + phase] = (float)timer.ReadMs();
+		}
+	}
+
+	return ret;
+}
+
+void Application::RecordSamples(const std::vector<uint>& modules, const std::vector<float>& samples)
+{
+	for (uint module : modules)
+	{
+		for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+		{
+			profiler.AddSample(module, (ProfilerPhase)phase, samples[module * PROFILE_PHASE_COUNT + phase]);
+		}
+	}
+}
+
+// One tick of the game: physics step, audio and rules, drawing recorded into the render snapshot
+update_status Application::Simulate()
+{
+	std::fill(simulation_samples.begin(), simulation_samples.end(), 0.0f);
+
+	update_status ret = CallModules(simulation_modules, PROFILE_PRE_UPDATE, simulation_samples);
+	if (ret == UPDATE_CONTINUE) ret = CallModules(simulation_modules, PROFILE_UPDATE, simulation_samples);
+	if (ret == UPDATE_CONTINUE) ret = CallModules(simulation_modules, PROFILE_POST_UPDATE, simulation_samples);
+
+	return ret;
+}
+
+void Application::StartSimulation()
+{
+	std::lock_guard<std::mutex> lock(simulation_mutex);
+	simulation_pending = true;
+	simulation_signal.notify_all();
+}
+
+// Blocks until the worker is idle, then reports the result and timings of its last tick
+update_status Application::WaitSimulation()
+{
+	std::unique_lock<std::mutex> lock(simulation_mutex);
+	simulation_signal.wait(lock, [this] { return !simulation_pending; });
+
+	RecordSamples(simulation_modules, simulation_samples);
+
+	return simulation_status;
+}
+
+void Application::SimulationThread()
+{
+	std::unique_lock<std::mutex> lock(simulation_mutex);
+
+	while (true)
+	{
+		simulation_signal.wait(lock, [this] { return simulation_pending || simulation_quit; });
+		if (!simulation_pending) break;
+
+		lock.unlock();
+		update_status ret = Simulate();
+		lock.lock();
+
+		simulation_status = ret;
+		simulation_pending = false;
+		simulation_signal.notify_all();
+	}
+}
+
+void Application::StopSimulationThread()
+{
+	if (!simulation_thread.joinable()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(simulation_mutex);
+		simulation_quit = true;
+		simulation_signal.notify_all();
+	}
+
+	// A tick still running is finished before the modules are cleaned up
+	simulation_thread.join();
 }
\ No newline at end of file
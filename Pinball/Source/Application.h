@@ -2,41 +2,98 @@
 
 #include "Globals.h"
 #include "Timer.h"
+#include "PerfTimer.h"
+#include "Profiler.h"
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 class Module;
 class ModuleWindow;
+class ModuleInput;
+class ModuleAssets;
 class ModuleRender;
 class ModuleAudio;
 class ModulePhysics;
 class ModuleGame;
 
+// Table values the simulator sweeps over, the defaults are the ones the game ships with
+struct TableTuning
+{
+	float flipper_torque = 150.0f;
+	float bumper_restitution = 1.5f;
+	float spring_force = 200.0f;
+	int extra_life_score = 1000;
+};
+
 class Application
 {
 public:
 
 	ModuleRender* renderer;
 	ModuleWindow* window;
+	ModuleInput* input;
+	ModuleAssets* assets;
 	ModuleAudio* audio;
 	ModulePhysics* physics;
 	ModuleGame* scene_intro;
 
+	// Command line options
+	bool headless = false;			// -headless: no window, render or audio, one physics step per frame
+	uint64 max_frames = 0;			// -frames <n>: stop after n frames, 0 runs until the window is closed
+	const char* input_script = NULL;	// -input <file>: drive the game from an input script
+	const char* profile_csv = NULL;		// -profile <file>: dump the per module timings to a csv on exit
+	bool pipelined = false;			// -pipelined: simulate the next tick on a worker thread while the last one is drawn
+	const char* record_file = NULL;		// -record <file>: save the input of every tick to a replay on exit
+	const char* replay_file = NULL;		// -replay <file>: play a replay back, stops when it ends
+	const char* table_file = "Assets/Ruby/ruby.table";	// -table <file>: baked table to play on
+	uint ball_count = 1;			// -balls <n>: balls served at once, the extra ones start around the multiball spawn
+	uint physics_threads = 1;		// -physics-threads <n>: threads solving the physics islands, the result is the same for any count
+
+	// Batch runs play many games, the headless summary is left out of their output
+	bool quiet = false;
+
+	// Set before Init(), the table is built with these
+	TableTuning tuning;
+
+	// Frame time consumed by the tick being simulated
+	float dt = 0.0f;
+
+	// Per module timings, drawn by the renderer in debug mode
+	Profiler profiler;
+
 private:
 
 	std::vector<Module*> list_modules;
+	std::vector<uint> frame_modules;		// Always on the main thread: window, input and render
+	std::vector<uint> simulation_modules;	// One tick of game state, on the worker thread when pipelined
     uint64 frame_count = 0;
 
+	// Module timings, indexed by module * PROFILE_PHASE_COUNT + phase
+	std::vector<float> frame_samples;
+	std::vector<float> simulation_samples;
+
+	std::thread simulation_thread;
+	std::mutex simulation_mutex;
+	std::condition_variable simulation_signal;
+	bool simulation_pending = false;
+	bool simulation_quit = false;
+	update_status simulation_status = UPDATE_CONTINUE;
+
 	Timer ptimer;
 	Timer startup_time;
-	Timer frame_time;
+	PerfTimer frame_time;
 	Timer last_sec_frame_time;
 
 	uint32 last_sec_frame_count = 0;
 	uint32 prev_last_sec_frame_count = 0;
 
+	Timer run_time;
+
 public:
 
-	Application();
+	Application(int argc, char** argv);
 	~Application();
 
 	bool Init();
@@ -45,5 +102,15 @@ public:
 
 private:
 
-	void AddModule(Module* module);
+	void ParseArguments(int argc, char** argv);
+	void AddModule(Module* module, const char* name, bool simulation = false);
+
+	update_status CallModules(const std::vector<uint>& modules, ProfilerPhase phase, std::vector<float>& samples);
+	void RecordSamples(const std::vector<uint>& modules, const std::vector<float>& samples);
+
+	update_status Simulate();
+	void StartSimulation();
+	update_status WaitSimulation();
+	void SimulationThread();
+	void StopSimulationThread();
 };
\ No newline at end of file
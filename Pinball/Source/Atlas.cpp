@@ -0,0 +1,68 @@
+#include "Atlas.h"
+
+#include <algorithm>
+
+std::vector<Image> PackAtlas(const std::vector<Image>& images, std::vector<AtlasRect>& rects)
+{
+	rects.assign(images.size(), AtlasRect{ 0, Rectangle{ 0, 0, 0, 0 } });
+
+	std::vector<uint> order(images.size());
+	for (uint i = 0; i < order.size(); ++i) order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [&images](uint a, uint b) { return images[a].height > images[b].height; });
+
+	// Place every image, a shelf is as tall as its first (tallest) image
+	std::vector<int> page_heights;
+	int page = -1;
+	int x = 0, y = 0, shelf_height = 0;
+
+	for (uint i : order)
+	{
+		int width = images[i].width + ATLAS_PADDING * 2;
+		int height = images[i].height + ATLAS_PADDING * 2;
+
+		if (width > ATLAS_PAGE_SIZE || height > ATLAS_PAGE_SIZE)
+		{
+			LOG("Image too big for an atlas page: %dx%d", images[i].width, images[i].height);
+			continue;
+		}
+
+		if (page >= 0 && x + width > ATLAS_PAGE_SIZE)
+		{
+			x = 0;
+			y += shelf_height;
+			shelf_height = 0;
+		}
+
+		if (page < 0 || y + height > ATLAS_PAGE_SIZE)
+		{
+			page_heights.push_back(0);
+			page++;
+			x = y = shelf_height = 0;
+		}
+
+		rects[i].page = page;
+		rects[i].rect = Rectangle{ (float)(x + ATLAS_PADDING), (float)(y + ATLAS_PADDING), (float)images[i].width, (float)images[i].height };
+
+		x += width;
+		shelf_height = MAX(shelf_height, height);
+		page_heights[page] = MAX(page_heights[page], y + height);
+	}
+
+	// Pages are only as tall as their content
+	std::vector<Image> pages;
+	for (int height : page_heights)
+	{
+		pages.push_back(GenImageColor(ATLAS_PAGE_SIZE, height, BLANK));
+	}
+
+	for (uint i = 0; i < images.size(); ++i)
+	{
+		if (images[i].data == NULL || rects[i].rect.width == 0) continue;
+
+		Rectangle source = { 0, 0, (float)images[i].width, (float)images[i].height };
+		ImageDraw(&pages[rects[i].page], images[i], source, rects[i].rect, WHITE);
+	}
+
+	return pages;
+}
\ No newline at end of file
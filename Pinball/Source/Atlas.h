@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <vector>
+
+#define ATLAS_PAGE_SIZE 1024
+#define ATLAS_PADDING 1 // Empty pixels around every image, so filtering never samples a neighbour
+
+// Where an image ended up in the atlas
+struct AtlasRect
+{
+	int page;
+	Rectangle rect;
+};
+
+// Packs the images in shelves, tallest first, in as few pages as possible
+// rects[i] is filled with the page and area of images[i], the returned pages are owned by the caller
+std::vector<Image> PackAtlas(const std::vector<Image>& images, std::vector<AtlasRect>& rects);
\ No newline at end of file
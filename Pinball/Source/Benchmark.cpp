@@ -0,0 +1,341 @@
+#include "Benchmark.h"
+#include "AllocationCounter.h"
+#include "Application.h"
+#include "ModuleGame.h"
+#include "ModulePhysics.h"
+#include "ModuleRender.h"
+#include "PerfTimer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+// Counts the fixtures a broadphase query reports, the pair search runs one per moving proxy
+class BenchmarkQuery : public b2QueryCallback
+{
+public:
+	bool ReportFixture(b2Fixture*)
+	{
+		found++;
+		return true;
+	}
+
+	uint found = 0;
+};
+
+struct BenchmarkResult
+{
+	const char* name;
+	uint iterations;
+	double median;	// Microseconds per call
+	double p99;
+	double allocations;	// Per call
+	double b2_allocations;
+};
+
+// Times body over iterations, each sample is a batch of calls so the fast ones are above the timer resolution
+// Reset runs untimed after every batch
+template <typename Body, typename Reset>
+static BenchmarkResult Measure(const char* name, uint iterations, uint batch, Body body, Reset reset)
+{
+	std::vector<double> samples(iterations);
+	uint64 allocated = 0;
+	uint64 b2_allocated = 0;
+
+	PerfTimer timer;
+	for (uint i = 0; i < iterations; ++i)
+	{
+		uint64 allocations_before = GetAllocationCount();
+		int32 b2_allocations_before = b2GetAllocCount();
+		timer.Start();
+
+		for (uint call = 0; call < batch; ++call) body();
+
+		samples[i] = timer.ReadMs() * 1000.0 / batch;
+		allocated += GetAllocationCount() - allocations_before;
+		b2_allocated += b2GetAllocCount() - b2_allocations_before;
+
+		reset();
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	double calls = (double)iterations * batch;
+	return BenchmarkResult{ name, iterations, samples[(iterations - 1) / 2], samples[((iterations - 1) * 99) / 100], (double)allocated / calls, (double)b2_allocated / calls };
+}
+
+template <typename Body>
+static BenchmarkResult Measure(const char* name, uint iterations, uint batch, Body body)
+{
+	return Measure(name, iterations, batch, body, []() {});
+}
+
+// Headless game on the given table, played until the board is built and the balls are in play
+static Application* CreateTable(const char* table, uint balls)
+{
+	char balls_arg[16];
+	sprintf_s(balls_arg, "%u", balls);
+
+	char* args[] = { (char*)"Pinball", (char*)"-headless", (char*)"-balls", balls_arg, (char*)"-table", (char*)table };
+	Application* App = new Application(sizeof(args) / sizeof(args[0]), args);
+	App->quiet = true;
+
+	bool ret = App->Init();
+	for (uint i = 0; ret && i < BENCHMARK_WARMUP_STEPS; ++i) ret = App->Update() == UPDATE_CONTINUE;
+
+	if (ret == false)
+	{
+		App->CleanUp();
+		delete App;
+		return NULL;
+	}
+
+	return App;
+}
+
+static void DestroyTable(Application* App)
+{
+	App->CleanUp();
+	delete App;
+}
+
+bool RunBenchmarks(uint iterations, const char* table)
+{
+	StartCountingAllocations();
+	std::vector<BenchmarkResult> results;
+
+	// b2World::Step alone, no game rules or event dispatch
+	static const uint step_balls[] = { 1, 10, 100 };
+	static const char* step_names[] = { "b2World::Step 1 ball", "b2World::Step 10 balls", "b2World::Step 100 balls" };
+
+	for (uint i = 0; i < sizeof(step_balls) / sizeof(step_balls[0]); ++i)
+	{
+		Application* App = CreateTable(table, step_balls[i]);
+		if (App == NULL) return false;
+
+		b2World* world = App->physics->GetWorld();
+		results.push_back(Measure(step_names[i], iterations, 1, [&]() { world->Step(PHYSICS_TIMESTEP, PHYSICS_VELOCITY_ITERATIONS, PHYSICS_POSITION_ITERATIONS); }));
+
+		DestroyTable(App);
+	}
+
+	// Every contact and body walked from a cold cache, through the Box2D lists and through the dense arrays
+	{
+		Application* App = CreateTable(table, 100);
+		if (App == NULL) return false;
+
+		b2World* world = App->physics->GetWorld();
+		b2Contact* const* contacts = world->GetContactArray();
+		b2Body* const* bodies = world->GetBodyArray();
+
+		std::vector<uchar> flush(BENCHMARK_CACHE_FLUSH_BYTES);
+		auto evict = [&]() { for (uint i = 0; i < flush.size(); i += 64) flush[i]++; };
+		volatile uint visited = 0;	// Read by nothing, keeps the walks from being optimized out
+
+		static char walk_names[4][64];
+		sprintf_s(walk_names[0], "b2Contact list walk x%d", world->GetContactCount());
+		sprintf_s(walk_names[1], "b2Contact array walk x%d", world->GetContactCount());
+		sprintf_s(walk_names[2], "b2Body list walk x%d", world->GetBodyCount());
+		sprintf_s(walk_names[3], "b2Body array walk x%d", world->GetBodyCount());
+
+		evict();
+		results.push_back(Measure(walk_names[0], iterations, 1, [&]() { for (b2Contact* c = world->GetContactList(); c; c = c->GetNext()) visited = visited + c->IsTouching(); }, evict));
+		results.push_back(Measure(walk_names[1], iterations, 1, [&]() { for (int32 i = 0; i < world->GetContactCount(); ++i) visited = visited + contacts[i]->IsTouching(); }, evict));
+		results.push_back(Measure(walk_names[2], iterations, 1, [&]() { for (b2Body* b = world->GetBodyList(); b; b = b->GetNext()) visited = visited + b->IsAwake(); }, evict));
+		results.push_back(Measure(walk_names[3], iterations, 1, [&]() { for (int32 i = 0; i < world->GetBodyCount(); ++i) visited = visited + bodies[i]->IsAwake(); }, evict));
+
+		DestroyTable(App);
+	}
+
+	// A ball sized box queried all over the table, mostly against the walls
+	{
+		Application* App = CreateTable(table, 1);
+		if (App == NULL) return false;
+
+		b2World* world = App->physics->GetWorld();
+		std::vector<b2AABB> boxes;
+		float half = PIXEL_TO_METERS(App->scene_intro->ballRad) + b2_aabbExtension;
+		for (int y = 0; y < SCREEN_HEIGHT; y += BENCHMARK_QUERY_SPACING)
+		{
+			for (int x = 0; x < SCREEN_WIDTH; x += BENCHMARK_QUERY_SPACING)
+			{
+				b2AABB box;
+				box.lowerBound.Set(PIXEL_TO_METERS(x) - half, PIXEL_TO_METERS(y) - half);
+				box.upperBound.Set(PIXEL_TO_METERS(x) + half, PIXEL_TO_METERS(y) + half);
+				boxes.push_back(box);
+			}
+		}
+
+		static char query_name[64];
+		sprintf_s(query_name, "b2World::QueryAABB x%u", (uint)boxes.size());
+
+		BenchmarkQuery query;
+		results.push_back(Measure(query_name, iterations, 1, [&]() { for (const b2AABB& box : boxes) world->QueryAABB(&query, box); }));
+
+		DestroyTable(App);
+	}
+
+	Application* App = CreateTable(table, 10);
+	if (App == NULL) return false;
+
+	ModulePhysics* physics = App->physics;
+	PhysBody* table_body = physics->GetStaticBody();
+
+	// Contacts of the balls against the walls and bumpers, queued by BeginContact() and delivered to ModuleGame::OnCollision()
+	std::vector<b2Contact*> contacts;
+	b2Contact* const* world_contacts = physics->GetWorld()->GetContactArray();
+	for (int32 i = 0; i < physics->GetWorld()->GetContactCount(); ++i)
+	{
+		b2Contact* contact = world_contacts[i];
+		if (contact->IsTouching() && !contact->GetFixtureA()->IsSensor() && !contact->GetFixtureB()->IsSensor()) contacts.push_back(contact);
+	}
+
+	if (contacts.empty())
+	{
+		printf("No contacts on the table after %u ticks, skipping the dispatch benchmark\n", BENCHMARK_WARMUP_STEPS);
+	}
+	else
+	{
+		static char dispatch_name[64];
+		sprintf_s(dispatch_name, "BeginContact to OnCollision x%u", (uint)contacts.size());
+
+		results.push_back(Measure(dispatch_name, iterations, 1, [&]()
+		{
+			for (b2Contact* contact : contacts) physics->BeginContact(contact);
+			physics->DispatchCollisions();
+		}));
+	}
+
+	// A ray across the whole table and a point in the playfield, both test every fixture of the static body
+	float normal_x, normal_y;
+	results.push_back(Measure("PhysBody::RayCast", iterations, 100, [&]() { table_body->RayCast(0, 400, SCREEN_WIDTH, 400, normal_x, normal_y); }));
+	results.push_back(Measure("PhysBody::Contains", iterations, 100, [&]() { table_body->Contains(SCREEN_WIDTH / 2, 400); }));
+
+	// Drawing only records commands, so both run as if there was a window, the recording is cleared untimed
+	App->headless = false;
+	physics->debug = true;
+
+	results.push_back(Measure("ModulePhysics debug draw", iterations, 1, [&]() { physics->PostUpdate(); }, [&]() { App->renderer->SwapSnapshots(); }));
+	results.push_back(Measure("ModuleGame::Update sprites", iterations, 1, [&]() { App->scene_intro->Update(); }, [&]() { App->renderer->SwapSnapshots(); }));
+
+	physics->debug = false;
+	App->headless = true;
+
+	DestroyTable(App);
+
+	printf("%-32s %10s %12s %12s %14s %14s\n", "benchmark", "iterations", "median us", "p99 us", "allocs/call", "b2Alloc/call");
+	for (const BenchmarkResult& result : results)
+	{
+		printf("%-32s %10u %12.3f %12.3f %14.3f %14.3f\n", result.name, result.iterations, result.median, result.p99, result.allocations, result.b2_allocations);
+	}
+
+	return true;
+}
+
+struct BallBenchmark
+{
+	uint balls;
+	uint left;
+	ProfilerStats step;
+};
+
+// Headless runs with 1, 2, 4... balls, the physics step time of each is taken from the last PROFILER_SAMPLES frames
+bool BenchmarkBalls(uint max_balls, const char* table)
+{
+	std::vector<BallBenchmark> results;
+
+	for (uint balls = 1; balls <= max_balls; balls *= 2)
+	{
+		char balls_arg[16], frames_arg[16];
+		sprintf_s(balls_arg, "%u", balls);
+		sprintf_s(frames_arg, "%u", BENCHMARK_WARMUP_STEPS + PROFILER_SAMPLES);
+
+		char* args[] = { (char*)"Pinball", (char*)"-headless", (char*)"-balls", balls_arg, (char*)"-frames", frames_arg, (char*)"-table", (char*)table };
+		Application* App = new Application(sizeof(args) / sizeof(args[0]), args);
+		App->quiet = true;
+
+		bool ret = App->Init();
+		while (ret && App->Update() == UPDATE_CONTINUE);
+
+		if (ret)
+		{
+			BallBenchmark result = { balls, (uint)App->scene_intro->balls.size(), ProfilerStats() };
+			for (int track = 0; track < App->profiler.GetTrackCount(); ++track)
+			{
+				if (strcmp(App->profiler.GetTrackName(track), "Physics") == 0) result.step = App->profiler.GetStats(track, PROFILE_PRE_UPDATE);
+			}
+			results.push_back(result);
+		}
+
+		ret = App->CleanUp() && ret;
+		delete App;
+
+		if (ret == false) return false;
+	}
+
+	// Balls drain during the run, the ones left show how many the last steps were simulating
+	printf("\n%8s %8s %10s %10s %10s %12s\n", "balls", "left", "min ms", "avg ms", "p99 ms", "avg us/ball");
+	for (const BallBenchmark& result : results)
+	{
+		printf("%8u %8u %10.3f %10.3f %10.3f %12.2f\n", result.balls, result.left, result.step.min, result.step.avg, result.step.p99,
+			result.step.avg * 1000.0f / MAX(result.left, 1u));
+	}
+
+	return true;
+}
+
+struct ThreadBenchmark
+{
+	uint threads;
+	uint32 state;
+	ProfilerStats step;
+};
+
+// The same headless run on 1, 2, 4... physics threads, the state hash at the end has to match on every count
+bool BenchmarkThreads(uint max_threads, const char* table)
+{
+	std::vector<ThreadBenchmark> results;
+
+	// Powers of two, then the count asked for
+	for (uint threads = 1;; threads = MIN(threads * 2, max_threads))
+	{
+		char threads_arg[16], balls_arg[16], frames_arg[16];
+		sprintf_s(threads_arg, "%u", threads);
+		sprintf_s(balls_arg, "%u", BENCHMARK_THREAD_BALLS);
+		sprintf_s(frames_arg, "%u", BENCHMARK_WARMUP_STEPS + PROFILER_SAMPLES);
+
+		char* args[] = { (char*)"Pinball", (char*)"-headless", (char*)"-physics-threads", threads_arg, (char*)"-balls", balls_arg, (char*)"-frames", frames_arg, (char*)"-table", (char*)table };
+		Application* App = new Application(sizeof(args) / sizeof(args[0]), args);
+		App->quiet = true;
+
+		bool ret = App->Init();
+		while (ret && App->Update() == UPDATE_CONTINUE);
+
+		if (ret)
+		{
+			ThreadBenchmark result = { threads, App->physics->GetStateHash(), ProfilerStats() };
+			for (int track = 0; track < App->profiler.GetTrackCount(); ++track)
+			{
+				if (strcmp(App->profiler.GetTrackName(track), "Physics") == 0) result.step = App->profiler.GetStats(track, PROFILE_PRE_UPDATE);
+			}
+			results.push_back(result);
+		}
+
+		ret = App->CleanUp() && ret;
+		delete App;
+
+		if (ret == false) return false;
+		if (threads == max_threads) break;
+	}
+
+	printf("\n%8s %10s %10s %10s %10s %10s\n", "threads", "min ms", "avg ms", "p99 ms", "speedup", "state");
+	for (const ThreadBenchmark& result : results)
+	{
+		printf("%8u %10.3f %10.3f %10.3f %10.2f %10.8x%s\n", result.threads, result.step.min, result.step.avg, result.step.p99,
+			results[0].step.avg / MAX(result.step.avg, 0.001f), result.state, (result.state == results[0].state) ? "" : " differs");
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Globals.h"
+
+#define BENCHMARK_ITERATIONS 1000 // Timed iterations per case of -bench
+#define BENCHMARK_WARMUP_STEPS 60 // Ticks played before measuring, the table is built and the balls are served
+#define BENCHMARK_CACHE_FLUSH_BYTES (16 << 20) // Touched between the cold cache samples, larger than the last level cache
+#define BENCHMARK_THREAD_BALLS 64 // Balls on the table for -bench-threads, enough islands to share out
+#define BENCHMARK_QUERY_SPACING 32 // Pixels between the ball sized broadphase queries laid over the table
+
+// Times the physics, collision dispatch and render submission hot paths on a headless table
+// Every case prints the median and p99 time of one call and the heap allocations it made
+bool RunBenchmarks(uint iterations, const char* table);
+
+// Headless runs with 1, 2, 4... balls, prints the physics step time of each
+bool BenchmarkBalls(uint max_balls, const char* table);
+
+// Headless runs with the physics islands solved on 1, 2, 4... threads, prints the step time and the end state of each
+bool BenchmarkThreads(uint max_threads, const char* table);
\ No newline at end of file
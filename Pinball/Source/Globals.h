@@ -8,6 +8,9 @@
 
 void log(const char file[], int line, const char* format, ...);
 
+// Copies the next space separated word of a text file line, returns 0 at the end of the line
+int ReadToken(const char*& cursor, char* token, int size);
+
 #define CAP(n) ((n <= 0.0f) ? n=0.0f : (n >= 1.0f) ? n=1.0f : n=n)
 
 #define DEGTORAD 0.0174532925199432957f
@@ -39,4 +42,5 @@ enum update_status
 #define WIN_FULLSCREEN_DESKTOP false
 #define VSYNC				false
 #define FPS					  165
+#define HEADLESS_DEFAULT_FRAMES 36000
 #define TITLE "Pokemon Pinball GBA"
\ No newline at end of file
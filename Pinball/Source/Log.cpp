@@ -4,13 +4,29 @@
 
 void log(const char file[], int line, const char* format, ...)
 {
-	static char tmp_string[4096];
-	static char tmp_string2[4096];
-	static va_list  ap;
+	// On the stack, the table simulator logs from several threads at once
+	char tmp_string[4096];
+	char tmp_string2[4096];
+	va_list  ap;
 
 	// Construct the string from variable arguments
 	va_start(ap, format);
 	vsprintf_s(tmp_string, 4096, format, ap);
 	va_end(ap);
 	sprintf_s(tmp_string2, 4096, "\n%s(%d) : %s", file, line, tmp_string);
+}
+
+int ReadToken(const char*& cursor, char* token, int size)
+{
+	while (*cursor == ' ' || *cursor == '\t') cursor++;
+
+	int length = 0;
+	while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t' && *cursor != '\n' && *cursor != '\r')
+	{
+		if (length < size - 1) token[length++] = *cursor;
+		cursor++;
+	}
+
+	token[length] = '\0';
+	return (length > 0) ? 1 : 0;
 }
\ No newline at end of file
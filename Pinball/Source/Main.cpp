@@ -1,9 +1,16 @@
 #include "Application.h"
 #include "Globals.h"
+#include "Table.h"
+#include "Outline.h"
+#include "Simulator.h"
+#include "Benchmark.h"
+#include "SelfTest.h"
 
 #include "raylib.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <thread>
 
 enum main_states
 {
@@ -16,6 +23,53 @@ enum main_states
 
 int main(int argc, char ** argv)
 {
+	// -bake-table <source> <table>: build a table file and exit, the game does not start
+	if (argc == 4 && strcmp(argv[1], "-bake-table") == 0)
+	{
+		return Table::Bake(argv[2], argv[3]) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// -trace-table <source> <mask> <table> [tolerance]: same, with the plain walls traced from a collision mask
+	if ((argc == 5 || argc == 6) && strcmp(argv[1], "-trace-table") == 0)
+	{
+		float tolerance = (argc == 6) ? strtof(argv[5], NULL) : OUTLINE_TOLERANCE;
+		return TraceTable(argv[2], argv[3], argv[4], tolerance) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// -bench [iterations] [table]: median and p99 time and heap allocations of the physics and render hot paths
+	if (argc >= 2 && argc <= 4 && strcmp(argv[1], "-bench") == 0)
+	{
+		uint iterations = (argc >= 3) ? (uint)strtoul(argv[2], NULL, 10) : BENCHMARK_ITERATIONS;
+		return RunBenchmarks(MAX(iterations, 1u), (argc == 4) ? argv[3] : "Assets/Ruby/ruby.table") ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// -bench-balls [max balls] [table]: physics step time against the number of balls on the table, up to 256 by default
+	if (argc >= 2 && argc <= 4 && strcmp(argv[1], "-bench-balls") == 0)
+	{
+		uint max_balls = (argc >= 3) ? (uint)strtoul(argv[2], NULL, 10) : 256;
+		return BenchmarkBalls(max_balls, (argc == 4) ? argv[3] : "Assets/Ruby/ruby.table") ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// -bench-threads [max threads] [table]: physics step time against the threads solving the islands, up to every core by default
+	if (argc >= 2 && argc <= 4 && strcmp(argv[1], "-bench-threads") == 0)
+	{
+		uint max_threads = (argc >= 3) ? (uint)strtoul(argv[2], NULL, 10) : std::thread::hardware_concurrency();
+		return BenchmarkThreads(MAX(max_threads, 1u), (argc == 4) ? argv[3] : "Assets/Ruby/ruby.table") ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// -simulate <games> [sweep file|-] [input script]: batch of headless games per tuning set, on every core
+	if (argc >= 3 && argc <= 5 && strcmp(argv[1], "-simulate") == 0)
+	{
+		const char* sweep = (argc >= 4 && strcmp(argv[3], "-") != 0) ? argv[3] : NULL;
+		return SimulateTable((uint)strtoul(argv[2], NULL, 10), sweep, (argc == 5) ? argv[4] : NULL) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// -test [table]: headless checks of the game on the table, fails if any of them does
+	if (argc >= 2 && argc <= 3 && strcmp(argv[1], "-test") == 0)
+	{
+		return RunSelfTests((argc == 3) ? argv[2] : "Assets/Ruby/ruby.table") ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
 	LOG("Starting game '%s'...", TITLE);
 
 	int main_return = EXIT_FAILURE;
@@ -29,7 +83,7 @@ int main(int argc, char ** argv)
 		case MAIN_CREATION:
 
 			LOG("-------------- Application Creation --------------");
-			App = new Application();
+			App = new Application(argc, argv);
 			state = MAIN_START;
 			break;
 
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+
+// Read only view of a whole file, the OS pages it in on first access
+// Kept apart from Globals.h, windows.h and raylib.h cannot be included together
+class MappedFile
+{
+public:
+
+	MappedFile() {}
+	~MappedFile();
+
+	bool Open(const char* path);
+	void Close();
+
+	const void* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const void* data = NULL;
+	size_t size = 0;
+	void* mapping = NULL; // Windows file mapping handle
+};
\ No newline at end of file
@@ -75,4 +75,9 @@ public:
 	virtual void OnCollision(PhysBody* bodyA, PhysBody* bodyB, int dir)
 	{
 	}
+
+	// A body left a sensor, entering one is reported through OnCollision()
+	virtual void OnSensorExit(PhysBody* sensor, PhysBody* other, int dir)
+	{
+	}
 };
\ No newline at end of file
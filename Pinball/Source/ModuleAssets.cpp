@@ -0,0 +1,291 @@
+#include "Globals.h"
+#include "Application.h"
+#include "ModuleAssets.h"
+#include "ModuleAudio.h"
+#include "ModuleRender.h"
+#include "PerfTimer.h"
+
+#include "raylib.h"
+
+ModuleAssets::ModuleAssets(Application* app, bool start_enabled) : Module(app, start_enabled)
+{
+	quit = false;
+	required_count = 0;
+	required_uploaded = 0;
+}
+
+// Destructor
+ModuleAssets::~ModuleAssets()
+{}
+
+bool ModuleAssets::Init()
+{
+	LOG("Starting asset loader threads");
+
+	// Leave a core for the main thread
+	uint cores = std::thread::hardware_concurrency();
+	uint count = (cores > 1) ? MIN(cores - 1, ASSET_MAX_WORKERS) : 1;
+
+	for (uint i = 0; i < count; ++i)
+	{
+		workers.emplace_back(&ModuleAssets::WorkerThread, this);
+	}
+
+	return true;
+}
+
+// Upload what the workers decoded, required assets first
+update_status ModuleAssets::PreUpdate()
+{
+	bool loading = !IsReady();
+	PerfTimer budget;
+
+	while (budget.ReadMs() < ASSET_UPLOAD_BUDGET_MS)
+	{
+		uint index;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (decoded.empty()) break;
+
+			index = decoded.front();
+			decoded.pop_front();
+		}
+
+		Upload(jobs[index]);
+	}
+
+	// Progress bar until the game can draw its first frame
+	if (loading)
+	{
+		App->renderer->DrawText("LOADING", { 196, 390 }, GetFontDefault(), 30, 3, DARKGRAY);
+		App->renderer->DrawRectangle({ 96, 430, 320, 20 }, LIGHTGRAY);
+		App->renderer->DrawRectangle({ 96, 430, 320 * GetProgress(), 20 }, DARKGRAY);
+	}
+
+	return UPDATE_CONTINUE;
+}
+
+bool ModuleAssets::CleanUp()
+{
+	LOG("Stopping asset loader threads");
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+		pending.clear();
+		signal.notify_all();
+	}
+
+	for (std::thread& worker : workers) worker.join();
+	workers.clear();
+
+	// Decoded but never uploaded
+	for (uint index : decoded)
+	{
+		UnloadImage(jobs[index].image);
+		UnloadWave(jobs[index].wave);
+		for (Image& page : jobs[index].pages) UnloadImage(page);
+	}
+
+	decoded.clear();
+	jobs.clear();
+
+	for (Texture2D& texture : sprite_textures) UnloadTexture(texture);
+	sprite_textures.clear();
+
+	return true;
+}
+
+void ModuleAssets::QueueTexture(const char* path, Texture2D* texture, AssetPriority priority, int scale)
+{
+	AssetJob job = {};
+	job.type = ASSET_TEXTURE;
+	job.priority = priority;
+	job.path = path;
+	job.texture = texture;
+	job.scale = scale;
+
+	*texture = Texture2D{};
+
+	Queue(job);
+}
+
+void ModuleAssets::QueueSprite(const char* path, Sprite* sprite, AssetPriority priority, int scale)
+{
+	AssetJob job = {};
+	job.type = ASSET_TEXTURE;
+	job.priority = priority;
+	job.path = path;
+	job.sprite = sprite;
+	job.scale = scale;
+
+	*sprite = Sprite();
+
+	Queue(job);
+}
+
+void ModuleAssets::QueueFx(const char* path, int* fx, AssetPriority priority, float volume)
+{
+	AssetJob job = {};
+	job.type = ASSET_FX;
+	job.priority = priority;
+	job.path = path;
+	job.fx = fx;
+	job.volume = volume;
+
+	*fx = 0;
+
+	Queue(job);
+}
+
+void ModuleAssets::AddSprite(const char* path, Sprite* sprite)
+{
+	atlas.sprite_paths.push_back(path);
+	atlas.sprites.push_back(sprite);
+
+	*sprite = Sprite();
+}
+
+void ModuleAssets::QueueAtlas(AssetPriority priority)
+{
+	atlas.type = ASSET_ATLAS;
+	atlas.priority = priority;
+	atlas.path = "atlas";
+
+	Queue(atlas);
+	atlas = AssetJob();
+}
+
+void ModuleAssets::Queue(const AssetJob& job)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	jobs.push_back(job);
+	if (job.priority == ASSET_REQUIRED) required_count++;
+
+	InsertByPriority(pending, (uint)jobs.size() - 1);
+	signal.notify_one();
+}
+
+// Required assets jump ahead of the deferred ones still waiting
+void ModuleAssets::InsertByPriority(std::deque<uint>& queue, uint index)
+{
+	if (jobs[index].priority == ASSET_DEFERRED)
+	{
+		queue.push_back(index);
+		return;
+	}
+
+	auto it = queue.begin();
+	while (it != queue.end() && jobs[*it].priority == ASSET_REQUIRED) ++it;
+	queue.insert(it, index);
+}
+
+bool ModuleAssets::IsReady() const
+{
+	return required_uploaded == required_count;
+}
+
+float ModuleAssets::GetProgress() const
+{
+	return (required_count > 0) ? (float)required_uploaded / required_count : 1.0f;
+}
+
+void ModuleAssets::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true)
+	{
+		signal.wait(lock, [this] { return quit || !pending.empty(); });
+		if (quit) break;
+
+		uint index = pending.front();
+		pending.pop_front();
+		AssetJob& job = jobs[index];
+
+		// File reading and decoding need no graphics or audio context
+		lock.unlock();
+		switch (job.type)
+		{
+		case ASSET_TEXTURE: job.image = LoadImage(job.path.c_str()); break;
+		case ASSET_FX: job.wave = LoadWave(job.path.c_str()); break;
+		case ASSET_ATLAS: DecodeAtlas(job); break;
+		}
+		lock.lock();
+
+		InsertByPriority(decoded, index);
+	}
+}
+
+// Decode every sprite and pack them, only the pages are left to upload
+void ModuleAssets::DecodeAtlas(AssetJob& job)
+{
+	std::vector<Image> images;
+	for (const std::string& path : job.sprite_paths)
+	{
+		images.push_back(LoadImage(path.c_str()));
+		if (images.back().data == NULL) LOG("Cannot load sprite: %s", path.c_str());
+	}
+
+	job.pages = PackAtlas(images, job.rects);
+
+	for (Image& image : images) UnloadImage(image);
+}
+
+void ModuleAssets::Upload(AssetJob& job)
+{
+	if (job.type == ASSET_ATLAS)
+	{
+		uint first_page = (uint)sprite_textures.size();
+		for (Image& page : job.pages)
+		{
+			sprite_textures.push_back(LoadTextureFromImage(page));
+			UnloadImage(page);
+		}
+		job.pages.clear();
+
+		for (uint i = 0; i < job.sprites.size(); ++i)
+		{
+			// Sprites that failed to load or did not fit were never placed
+			if (job.rects[i].rect.width == 0) continue;
+
+			job.sprites[i]->texture = sprite_textures[first_page + job.rects[i].page];
+			job.sprites[i]->rect = job.rects[i].rect;
+		}
+	}
+	else if (job.type == ASSET_TEXTURE)
+	{
+		if (job.image.data == NULL) LOG("Cannot load texture: %s", job.path.c_str());
+
+		Texture2D texture = LoadTextureFromImage(job.image);
+		UnloadImage(job.image);
+
+		// Drawn at the scaled size wherever the texture is used whole
+		texture.width *= job.scale;
+		texture.height *= job.scale;
+
+		if (job.sprite != NULL)
+		{
+			sprite_textures.push_back(texture);
+			job.sprite->texture = texture;
+			job.sprite->rect = Rectangle{ 0, 0, (float)texture.width, (float)texture.height };
+		}
+		else
+		{
+			*job.texture = texture;
+		}
+	}
+	else
+	{
+		if (job.wave.data == NULL) LOG("Cannot load sound: %s", job.path.c_str());
+
+		unsigned int fx = App->audio->LoadFx(job.wave);
+		UnloadWave(job.wave);
+
+		App->audio->SetFxVolume(fx, job.volume);
+		*job.fx = (int)fx;
+	}
+
+	if (job.priority == ASSET_REQUIRED) required_uploaded++;
+}
\ No newline at end of file
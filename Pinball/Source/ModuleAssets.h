@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Module.h"
+#include "Globals.h"
+#include "Atlas.h"
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define ASSET_MAX_WORKERS 4
+#define ASSET_UPLOAD_BUDGET_MS 8.0 // Max time spent uploading per frame, keeps the loading screen moving
+
+enum AssetType
+{
+	ASSET_TEXTURE,
+	ASSET_FX,
+	ASSET_ATLAS
+};
+
+struct Sprite;
+
+enum AssetPriority
+{
+	ASSET_REQUIRED,		// Needed before the game can draw its first frame
+	ASSET_DEFERRED		// Streamed in while the game runs
+};
+
+struct AssetJob
+{
+	AssetType type;
+	AssetPriority priority;
+	std::string path;
+
+	// Where the result goes once it is uploaded
+	Texture2D* texture;
+	Sprite* sprite;
+	int scale;
+	int* fx;
+	float volume;
+	std::vector<std::string> sprite_paths;
+	std::vector<Sprite*> sprites;
+
+	// Decoded on a worker thread
+	Image image;
+	Wave wave;
+	std::vector<Image> pages;
+	std::vector<AtlasRect> rects;
+};
+
+// Decodes images and sounds on a pool of worker threads, only the GPU and audio uploads happen on the main thread
+class ModuleAssets : public Module
+{
+public:
+
+	ModuleAssets(Application* app, bool start_enabled = true);
+	~ModuleAssets();
+
+	bool Init();
+	update_status PreUpdate();
+	bool CleanUp();
+
+	// The target is written once the asset is uploaded, it stays empty (id 0) until then
+	void QueueTexture(const char* path, Texture2D* texture, AssetPriority priority, int scale = 1);
+	void QueueFx(const char* path, int* fx, AssetPriority priority, float volume = 1.0f);
+
+	// Sprites are packed together into atlas pages, QueueAtlas() loads the ones added so far as one job
+	void AddSprite(const char* path, Sprite* sprite);
+	void QueueAtlas(AssetPriority priority);
+	// A sprite with a texture of its own, for frames that are scaled or not needed right away
+	void QueueSprite(const char* path, Sprite* sprite, AssetPriority priority, int scale = 1);
+
+	// All the required assets are uploaded, nothing is simulated before
+	bool IsReady() const;
+	float GetProgress() const;
+
+private:
+
+	void Queue(const AssetJob& job);
+	void InsertByPriority(std::deque<uint>& queue, uint index);
+	void WorkerThread();
+	void DecodeAtlas(AssetJob& job);
+	void Upload(AssetJob& job);
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable signal;
+	bool quit;
+
+	std::deque<AssetJob> jobs;
+	std::deque<uint> pending;	// Queued, waiting for a worker
+	std::deque<uint> decoded;	// Decoded, waiting for the upload
+
+	uint required_count;
+	uint required_uploaded;
+
+	AssetJob atlas;
+	std::vector<Texture2D> sprite_textures;	// Atlas pages and sprites queued on their own
+};
\ No newline at end of file
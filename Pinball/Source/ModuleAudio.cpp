@@ -29,6 +29,17 @@ bool ModuleAudio::Init()
 	return ret;
 }
 
+// Keep the music stream buffers filled
+update_status ModuleAudio::Update()
+{
+	if (IsMusicReady(music))
+	{
+		UpdateMusicStream(music);
+	}
+
+	return UPDATE_CONTINUE;
+}
+
 // Called before quitting
 bool ModuleAudio::CleanUp()
 {
@@ -59,17 +70,53 @@ bool ModuleAudio::PlayMusic(const char* path, float fade_time)
 		return false;
 
 	bool ret = true;
-	
-    StopMusicStream(music);
+
+	if (IsMusicReady(music))
+	{
+		StopMusicStream(music);
+		UnloadMusicStream(music);
+	}
+
     music = LoadMusicStream(path);
-    
-    PlayMusicStream(music);
 
-	LOG("Successfully playing %s", path);
+	if (IsMusicReady(music) == false)
+	{
+		LOG("Cannot load music: %s", path);
+		ret = false;
+	}
+	else
+	{
+		PlayMusicStream(music);
+		LOG("Successfully playing %s", path);
+	}
 
 	return ret;
 }
 
+void ModuleAudio::StopMusic()
+{
+	if (IsEnabled() && IsMusicReady(music))
+	{
+		StopMusicStream(music);
+	}
+}
+
+void ModuleAudio::RestartMusic()
+{
+	if (IsEnabled() && IsMusicReady(music))
+	{
+		PlayMusicStream(music);
+	}
+}
+
+void ModuleAudio::SetMusicVolume(float volume)
+{
+	if (IsEnabled() && IsMusicReady(music))
+	{
+		::SetMusicVolume(music, volume);
+	}
+}
+
 // Load WAV
 unsigned int ModuleAudio::LoadFx(const char* path)
 {
@@ -94,6 +141,26 @@ unsigned int ModuleAudio::LoadFx(const char* path)
 	return ret;
 }
 
+// Load an already decoded sound
+unsigned int ModuleAudio::LoadFx(Wave wave)
+{
+	if(IsEnabled() == false || fx_count >= MAX_SOUNDS)
+		return 0;
+
+	unsigned int ret = 0;
+
+	Sound sound = LoadSoundFromWave(wave);
+
+	if(sound.stream.buffer != NULL)
+	{
+		fx[fx_count++] = sound;
+
+		ret = fx_count;
+	}
+
+	return ret;
+}
+
 // Play WAV
 bool ModuleAudio::PlayFx(unsigned int id, int repeat)
 {
@@ -105,10 +172,27 @@ bool ModuleAudio::PlayFx(unsigned int id, int repeat)
 	bool ret = false;
 	/*fx_count++;*/
 
-	if (id <= fx_count) {
+	// Sounds still loading have no id yet
+	if (id > 0 && id <= fx_count) {
 		PlaySound(fx[id-1]);
 		
 	}
 
 	return ret;
+}
+
+void ModuleAudio::StopFx(unsigned int id)
+{
+	if (IsEnabled() && id > 0 && id <= fx_count)
+	{
+		StopSound(fx[id - 1]);
+	}
+}
+
+void ModuleAudio::SetFxVolume(unsigned int id, float volume)
+{
+	if (IsEnabled() && id > 0 && id <= fx_count)
+	{
+		SetSoundVolume(fx[id - 1], volume);
+	}
 }
\ No newline at end of file
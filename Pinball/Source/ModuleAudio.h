@@ -13,17 +13,27 @@ public:
 	~ModuleAudio();
 
 	bool Init();
+	update_status Update();
 	bool CleanUp();
 
 	// Play a music file
 	bool PlayMusic(const char* path, float fade_time = DEFAULT_MUSIC_FADE_TIME);
 
+	// Stop the music, RestartMusic() plays it again from the beginning
+	void StopMusic();
+	void RestartMusic();
+	void SetMusicVolume(float volume);
+
 	// Load a sound in memory
 	unsigned int LoadFx(const char* path);
+	unsigned int LoadFx(Wave wave);
 
 	// Play a previously loaded sound
 	bool PlayFx(unsigned int fx, int repeat = 0);
 
+	void StopFx(unsigned int fx);
+	void SetFxVolume(unsigned int fx, float volume);
+
 private:
 
 	Music music;
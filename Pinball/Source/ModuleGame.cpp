@@ -4,6 +4,11 @@
 #include "ModuleGame.h"
 #include "ModuleAudio.h"
 #include "ModulePhysics.h"
+#include "ModuleInput.h"
+#include "ModuleAssets.h"
+#include "Animations.h"
+
+#include <algorithm>
 
 class PhysicEntity
 {
@@ -12,6 +17,7 @@ protected:
 	PhysicEntity(PhysBody* _body, Module* _listener)
 		: body(_body)
 		, listener(_listener)
+		, render(_listener->App->renderer)
 	{
 		if (body != nullptr) {
 			body->listener = listener;
@@ -19,7 +25,12 @@ protected:
 	}
 
 public:
-	virtual ~PhysicEntity() = default;
+	// Anchors, sensors and other extra bodies stay in the world until it is destroyed
+	virtual ~PhysicEntity()
+	{
+		if (body != nullptr) listener->App->physics->DestroyBody(body);
+	}
+
 	virtual void Update() = 0;
 
 	virtual int RayHit(vec2<int> ray, vec2<int> mouse, vec2<float>& normal)
@@ -30,48 +41,29 @@ public:
 protected:
 	PhysBody* body;
 	Module* listener;
+	ModuleRender* render;
 };
 
-class Ball : public PhysicEntity
+// Entity drawn with the current frame of one of the game animations
+class AnimatedEntity : public PhysicEntity
 {
-public:
-	Ball(ModulePhysics* physics, int _x, int _y, Module* _listener, Texture2D _texture)
-		: PhysicEntity(physics->CreateCircle(_x, _y, 10, b2_dynamicBody), _listener)
-		, texture(_texture)
-	{
-
-	}
+protected:
 
-	~Ball() {};
+	AnimatedEntity(PhysBody* _body, Module* _listener, const Animations& _animations, uint _animation)
+		: PhysicEntity(_body, _listener)
+		, animations(_animations)
+		, animation(_animation)
+	{}
 
-	void Update() override
+	const Sprite& GetSprite() const
 	{
-		int x, y;
-		body->GetPhysicPosition(x, y);
-		Vector2 position{ (float)x, (float)y };
-		float scale = 2.0f;
-		Rectangle source = { 0.0f, 0.0f, (float)texture.width, (float)texture.height };
-		Rectangle dest = { position.x, position.y, (float)texture.width * scale, (float)texture.height * scale };
-		Vector2 origin = { (float)(texture.width * scale / 2), (float)(texture.height * scale / 2) };
-		float rotation = body->GetRotation() * RAD2DEG;
-		DrawTexturePro(texture, source, dest, origin, rotation, WHITE);
+		return animations.GetFrame(animation);
 	}
 
-	void ShootBall(const b2Vec2& force) {
-		body->body->ApplyLinearImpulseToCenter(force, true);
-	}
-	void updatePosition()
-	{
-		b2Vec2 pos;
-		pos.x = 9.7;
-		pos.y = 10.0;
-
-		body->body->SetTransform(pos, 0.0f);
-	}
-
-private:
-	Texture2D texture;
+	const Animations& animations;
 
+public:
+	uint animation;
 };
 
 class Box : public PhysicEntity
@@ -87,7 +79,7 @@ public:
 	{
 		int x, y;
 		body->GetPhysicPosition(x, y);
-		DrawTexturePro(texture, Rectangle{ 0, 0, (float)texture.width, (float)texture.height },
+		render->DrawSprite(texture, Rectangle{ 0, 0, (float)texture.width, (float)texture.height },
 			Rectangle{ (float)x, (float)y, (float)texture.width, (float)texture.height },
 			Vector2{ (float)texture.width / 2.0f, (float)texture.height / 2.0f }, body->GetRotation() * RAD2DEG, WHITE);
 	}
@@ -102,392 +94,116 @@ private:
 
 };
 
+// Builds every static part of the table as fixtures of the physics static body and draws the board under them
+// The fixtures are added grouped by interaction, the blocker is kept to open and close the launch lane
 class Board : public PhysicEntity
 {
 public:
-	static constexpr int board_circuit[108] =
-	{
-		240, 144,
-		187, 151,
-		123, 175,
-		80, 203,
-		47, 253,
-		28, 310,
-		25, 367,
-		26, 437,
-		41, 483,
-		60, 527,
-		75, 549,
-		93, 568,
-		93, 617,
-		86, 628,
-		69, 631,
-		56, 633,
-		49, 645,
-		47, 792,
-		79, 792,
-		79, 766,
-		134, 804,
-		197, 838,
-		197, 848,
-		1, 844,
-		0, 2,
-		511, 1,
-		509, 844,
-		284, 848,
-		284, 840,
-		400, 769,
-		400, 793,
-		430, 793,
-		430, 662,
-		421, 647,
-		413, 644,
-		393, 641,
-		383, 637,
-		382, 572,
-		421, 525,
-		447, 459,
-		456, 395,
-		453, 335,
-		438, 289,
-		445, 276,
-		467, 330,
-		471, 411,
-		472, 816,
-		501, 816,
-		499, 355,
-		478, 283,
-		434, 227,
-		376, 185,
-		329, 162,
-		276, 145
-	};
 
-	Board(ModulePhysics* physics, int _x, int _y, Module* _listener, Texture2D _texture)
-		: PhysicEntity(physics->CreateChain(0, 0, board_circuit, 108, b2_staticBody,1), _listener)
+	Board(ModulePhysics* physics, const Table& table, Module* _listener, Texture2D _texture)
+		: PhysicEntity(nullptr, _listener)
+		, physics(physics)
 		, texture(_texture)
 	{
+		static_assert(sizeof(TableVertex) == sizeof(b2Vec2), "Table vertices are read as b2Vec2");
 
-	}
-
-	void Update() override
-	{
-		int x, y;
-		body->GetPhysicPosition(x, y);
-		DrawTextureEx(texture, Vector2{ (float)x, (float)y }, body->GetRotation() * RAD2DEG, 2.0f, WHITE);
-	}
-
-private:
-	Texture2D texture;
-};
+		// Same listener the separate table bodies had
+		physics->GetStaticBody()->listener = _listener;
 
-class Block : public PhysicEntity
-{
-public:
+		std::vector<TablePart> parts;
+		for (uint i = 0; i < table.GetChainCount(); ++i) parts.push_back(TablePart{ table.GetChain(i).interaction, TABLE_PART_CHAIN, i });
+		for (uint i = 0; i < table.GetSensorCount(); ++i) parts.push_back(TablePart{ table.GetSensor(i).interaction, TABLE_PART_SENSOR, i });
+		for (uint i = 0; i < table.GetBumperCount(); ++i) parts.push_back(TablePart{ table.GetBumper(i).interaction, TABLE_PART_BUMPER, i });
 
-	static constexpr int board_limit[16] =
-	{
-		437, 284,
-		423, 253,
-		413, 237,
-		393, 206,
-		371, 182,
-		396, 200,
-		422, 236,
-		444, 274
-	};
-
-	Block(ModulePhysics* physics, int _x, int _y, Module* _listener, Texture2D _texture)
-		: PhysicEntity(physics->CreateChain(0, 0, board_limit, 16, b2_staticBody, 1), _listener)
-		, texture(_texture)
-	{
+		std::stable_sort(parts.begin(), parts.end(), [](const TablePart& a, const TablePart& b) { return a.interaction < b.interaction; });
 
+		for (const TablePart& part : parts)
+		{
+			if (part.type == TABLE_PART_CHAIN)
+			{
+				const TableChain& chain = table.GetChain(part.index);
+				b2Fixture* fixture = physics->AddStaticChain(reinterpret_cast<const b2Vec2*>(table.GetVertices(chain)), (int)chain.vertex_count, chain.interaction, chain.kind != TABLE_CHAIN_BOARD);
+				if (chain.kind == TABLE_CHAIN_BLOCKER) blockers.push_back(fixture);
+			}
+			else if (part.type == TABLE_PART_SENSOR)
+			{
+				const TableSensor& sensor = table.GetSensor(part.index);
+				physics->AddStaticSensor(sensor.x, sensor.y, sensor.width, sensor.height, sensor.interaction);
+			}
+			else
+			{
+				const TableBumper& bumper = table.GetBumper(part.index);
+				physics->AddStaticBumper(bumper.x, bumper.y, bumper.radius, bumper.interaction);
+			}
+		}
 	}
 
 	void Update() override
 	{
-		int x, y;
-		body->GetPhysicPosition(x, y);
-		DrawTextureEx(texture, Vector2{ (float)x, (float)y }, body->GetRotation() * RAD2DEG, 2.0f, WHITE);
+		render->DrawSprite(texture, Rectangle{ 0, 0, (float)texture.width, (float)texture.height }, Rectangle{ 0, 0, texture.width * 2.0f, texture.height * 2.0f }, Vector2{ 0, 0 }, 0.0f, WHITE, LAYER_BOARD);
 	}
+
+	// Tables without a blocker chain leave the launch lane open
 	void changeColision(bool flag) {
-		body->body->SetEnabled(flag);
+		for (b2Fixture* fixture : blockers) physics->SetFixtureEnabled(fixture, flag);
 	}
 
 private:
-	Texture2D texture;
-};
 
+	enum TablePartType { TABLE_PART_CHAIN, TABLE_PART_SENSOR, TABLE_PART_BUMPER };
 
-class Obstacle : public PhysicEntity
-{
-public:
-
-	static constexpr int circuit1[12] = {
-		138, 662,
-		175, 716,
-		175, 725,
-		173, 727,
-		137, 669, 
-		132, 663
-	};
-
-	static constexpr int circuit10[10] = {
-		133, 660,
-		169, 726,
-		140, 711,
-		130, 701,
-		130, 678
-	};
-
-	static constexpr int circuit2[38] = {
-		333, 193,
-		375, 229,
-		405, 280,
-		412, 322,
-		418, 379,
-		414, 423,
-		404, 465,
-		385, 507,
-		380, 491,
-		407, 410,
-		394, 404,
-		380, 414,
-		348, 473,
-		345, 450,
-		391, 339,
-		390, 300,
-		372, 255,
-		332, 231,
-		332, 209
-	};
-
-	static constexpr int circuit3[20] = {
-		290, 184,
-		293, 179,
-		300, 179,
-		304, 183,
-		304, 211,
-		303, 226,
-		300, 228,
-		293, 228,
-		290, 227,
-		289, 188
-	};
-
-	static constexpr int circuit4[18] = {
-		248, 176,
-		252, 172,
-		257, 172,
-		261, 176,
-		261, 223,
-		259, 227,
-		251, 226,
-		248, 224,
-		248, 181
-	};
-	static constexpr int circuit5[68] = {
-		219, 175,
-		219, 224,
-		213, 231,
-		212, 267,
-		217, 287,
-		221, 313,
-		231, 336,
-		240, 352,
-		240, 368,
-		214, 368,
-		202, 363,
-		202, 348,
-		205, 318,
-		208, 308,
-		207, 284,
-		191, 267,
-		175, 267,
-		157, 275,
-		151, 288,
-		153, 318,
-		156, 336,
-		160, 353,
-		163, 372,
-		164, 386,
-		154, 387,
-		149, 374,
-		146, 355,
-		141, 331,
-		140, 305,
-		141, 266,
-		154, 228,
-		164, 211,
-		180, 194,
-		208, 179
-	};
-
-	static constexpr int circuit6[50] = {
-
-		115, 217,
-		115, 236,
-		106, 253,
-		102, 270,
-		97, 293,
-		98, 319,
-		100, 347,
-		103, 371,
-		107, 396,
-		116, 426,
-		123, 448,
-		134, 478,
-		145, 503,
-		158, 517,
-		156, 533,
-		135, 554,
-		122, 545,
-		95, 504,
-		76, 463,
-		65, 420,
-		66, 397,
-		64, 366,
-		65, 320,
-		76, 275,
-		98, 233
-	};
-
-	static constexpr int circuit7[32] = {
-
-		100, 666,
-		100, 719,
-		103, 724,
-		111, 731,
-		118, 735,
-		132, 744,
-		169, 767,
-		183, 777,
-		184, 788,
-		173, 799,
-		94, 750,
-		90, 746,
-		86, 741,
-		86, 665,
-		90, 661,
-		96, 661
-	};
-	static constexpr int circuit8[26] = {
-
-		380, 667,
-		385, 662,
-		390, 662,
-		393, 666,
-		394, 740,
-		391, 744,
-		308, 799,
-		295, 788,
-		295, 781,
-		371, 731,
-		376, 724,
-		379, 719,
-		380, 672
-	};
-
-	static constexpr int circuit9[8] = {
-		347, 663,
-		342, 663,
-		305, 716,
-		305, 725
-	};
-	static constexpr int circuit19[10] = {
-
-		347, 662,
-		350, 665,
-		349, 704,
-		313, 727,
-		307, 726
-	};
-
-	Obstacle(ModulePhysics* physics, int _x, int _y, Module* _listener, Texture2D _texture)
-		: PhysicEntity(nullptr, _listener), texture(_texture)
-
-	{
-		CreateChain(physics, circuit1, sizeof(circuit1) / sizeof(circuit1[0]), _x, _y, LeftImpulser);
-		CreateChain(physics, circuit10, sizeof(circuit10) / sizeof(circuit10[0]), _x, _y, NoInteraction);
-
-		CreateChain(physics, circuit2, sizeof(circuit2) / sizeof(circuit2[0]), _x, _y, NoInteraction);
-		CreateChain(physics, circuit3, sizeof(circuit3) / sizeof(circuit3[0]), _x, _y, NoInteraction);
-		CreateChain(physics, circuit4, sizeof(circuit4) / sizeof(circuit4[0]), _x, _y, NoInteraction);
-		CreateChain(physics, circuit5, sizeof(circuit5) / sizeof(circuit5[0]), _x, _y, NoInteraction);
-		CreateChain(physics, circuit6, sizeof(circuit6) / sizeof(circuit6[0]), _x, _y, NoInteraction);
-		CreateChain(physics, circuit7, sizeof(circuit7) / sizeof(circuit7[0]), _x, _y, NoInteraction);
-		CreateChain(physics, circuit8, sizeof(circuit8) / sizeof(circuit8[0]), _x, _y, NoInteraction);
-
-		CreateChain(physics, circuit9, sizeof(circuit9) / sizeof(circuit9[0]), _x, _y, RightImpulser);
-		CreateChain(physics, circuit19, sizeof(circuit19) / sizeof(circuit19[0]), _x, _y, NoInteraction);
-	}
-
-	void Update() override
+	struct TablePart
 	{
-		for (const auto& body : bodies) {
-			int x, y;
-			body->GetPhysicPosition(x, y);
-			DrawTextureEx(texture, Vector2{ (float)x, (float)y }, body->GetRotation() * RAD2DEG, 2.0f, WHITE);
-		}
-	}
+		int interaction;
+		TablePartType type;
+		uint index;
+	};
 
-private:
+	ModulePhysics* physics;
 	Texture2D texture;
-	std::vector<PhysBody*> bodies; // Vector to hold objects
-
-
-	void CreateChain(ModulePhysics* physics, const int* circuit, int size, int _x, int _y, int i)
-	{
-		PhysBody* body = physics->CreateChain(_x, _y, circuit, size, b2_staticBody,i);
-		if (body != nullptr) {
-			bodies.push_back(body);
-		}
-	}
+	std::vector<b2Fixture*> blockers;
 };
 
 
-class Spring : public PhysicEntity {
+class Spring : public AnimatedEntity {
 public:
 	b2Vec2 axis = { 0.0f, -1.0f };
 	b2PrismaticJoint* joint;
 	PhysBody* bodyA;
 	PhysBody* bodyB;
 
-	Spring(ModulePhysics* physics, int _x, int _y, Module* _listener, const Texture2D& _texture) 
-		: PhysicEntity(physics->CreateRectangle(_x, _y, 40, 80, b2_dynamicBody, SpringImpulser), _listener)
-		, texture(_texture)
+	Spring(ModulePhysics* physics, int _x, int _y, Module* _listener, const Animations& _animations, uint _animation)
+		: AnimatedEntity(physics->CreateRectangle(_x, _y, 40, 80, b2_dynamicBody, SpringImpulser), _listener, _animations, _animation)
 	{
 		bodyA = this->body;
 		bodyB = physics->CreateRectangle(_x + 15, _y + bodyA->height, 40, 10, b2_staticBody, SpringImpulser);
 		joint = physics->CreateSpring(bodyA, bodyB, axis);
+		physics->AddInterpolatedBody(bodyA);
 	}
 
 	void Update() override
 	{
+		const Sprite& sprite = GetSprite();
 		int x, y;
 		int width = 20;
 		int height = 40;
-		body->GetPhysicPosition(x, y);
+		body->GetRenderPosition(x, y);
 		Vector2 position{ (float)x, (float)y };
 		float scale = 2.0f;
-		Rectangle source = { 0.0f, 0.0f, width, texture.height };
-		Rectangle dest = { position.x, position.y, (float)width * scale, (float)texture.height * scale };
+		Rectangle source = { 0.0f, 0.0f, width, sprite.rect.height };
+		Rectangle dest = { position.x, position.y, (float)width * scale, sprite.rect.height * scale };
 
 		Vector2 origin = { source.width * scale /2 , source.height * scale / 2 }; 
-		float rotation = body->GetRotation() * RAD2DEG;
-		DrawTexturePro(texture, source, dest, origin, rotation, WHITE);
+		float rotation = body->GetRenderRotation() * RAD2DEG;
+		render->DrawSprite(sprite, source, dest, origin, rotation, WHITE);
 	}
-
-public:
-	Texture2D texture;
-	
 };
 
-class Pikachu : public PhysicEntity
+class Pikachu : public AnimatedEntity
 {
 public:
-	Pikachu(ModulePhysics* physics, int _x, int _y, Module* _listener, const Texture2D& _texture)
-		: PhysicEntity(physics->CreateRectangleSensor(_x, _y, 20,20, b2_staticBody, PikachuImpulser), _listener), texture(_texture)
+	Pikachu(ModulePhysics* physics, int _x, int _y, Module* _listener, const Animations& _animations, uint _animation)
+		: AnimatedEntity(physics->CreateRectangleSensor(_x, _y, 20,20, b2_staticBody, PikachuImpulser), _listener, _animations, _animation)
 	{
 		// Initialize the bounding box based on the texture
 		width = 25;
@@ -496,16 +212,17 @@ public:
 
 	void Update() override
 	{
+		const Sprite& sprite = GetSprite();
 		Vector2 position = GetColliderPosition();
 		float scale = 2.0f;
 
-		Rectangle source = { 0.0f, 0.0f, (float)width, (float)texture.height };
-		Rectangle dest = { position.x, position.y - (texture.height / 1.5f), width * scale, (float)texture.height * scale };
+		Rectangle source = { 0.0f, 0.0f, (float)width, sprite.rect.height };
+		Rectangle dest = { position.x, position.y - (sprite.rect.height / 1.5f), width * scale, sprite.rect.height * scale };
 
 		Vector2 origin = GetTextureOrigin(); // Updated method to get the origin
 		float rotation = body->GetRotation() * RAD2DEG;
 
-		DrawTexturePro(texture, source, dest, origin, rotation, WHITE);
+		render->DrawSprite(sprite, source, dest, origin, rotation, WHITE);
 	}
 
 	int RayHit(vec2<int> ray, vec2<int> mouse, vec2<float>& normal) override
@@ -513,8 +230,11 @@ public:
 		return body->RayCast(ray.x, ray.y, mouse.x, mouse.y, normal.x, normal.y);
 	}
 
-	Texture2D texture;
-
+	// Pikachu runs to the side of the last flipper used, its kickback sensor goes with it
+	void MoveTo(int x, int y)
+	{
+		body->body->SetTransform(b2Vec2(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y)), 0.0f);
+	}
 
 private:
 	
@@ -531,87 +251,77 @@ private:
 	Vector2 GetTextureOrigin() const
 	{
 		// Adjust origin based on width and height to center the texture correctly
-		return { (float)(width), (float)(texture.height / 2) };
+		return { (float)(width), (float)((int)GetSprite().rect.height / 2) };
 	}
 };
 
-class Chinchou : public PhysicEntity {
+class Chinchou : public AnimatedEntity {
 
 public:
-	Chinchou(ModulePhysics* physics, int _x, int _y, Module* _listener, Texture2D _texture,int id)
-		: PhysicEntity(physics->CreateBumper(_x + 29, _y + 20, 15, b2_staticBody, id), _listener), texture(_texture) {
+	// The bumper itself is a fixture of the table, built by Board
+	Chinchou(const TableBumper& bumper, Module* _listener, const Animations& _animations, uint _animation)
+		: AnimatedEntity(nullptr, _listener, _animations, _animation), x(bumper.x), y(bumper.y) {
 		width = 29;
 		height = 20;
 	}
 
 	void Update() override
 	{
+		const Sprite& sprite = GetSprite();
 		Vector2 position = GetColliderPosition();
 		float scale = 2.0f;
 
-		Rectangle source = { 0.0f, 0.0f, (float)texture.width, (float)texture.height };
-		Rectangle dest = { position.x, position.y - (float)(height), (float)texture.width * scale, (float)texture.height * scale };
+		Rectangle source = { 0.0f, 0.0f, sprite.rect.width, sprite.rect.height };
+		Rectangle dest = { position.x, position.y - (float)(height), sprite.rect.width * scale, sprite.rect.height * scale };
 
 		Vector2 origin = GetTextureOrigin(); // Updated method to get the origin
 
-		float rotation = body->GetRotation() * RAD2DEG;
-
-		DrawTexturePro(texture, source, dest, origin, rotation, WHITE);
-	}
-
-	int RayHit(vec2<int> ray, vec2<int> mouse, vec2<float>& normal) override
-	{
-		return body->RayCast(ray.x, ray.y, mouse.x, mouse.y, normal.x, normal.y);
+		render->DrawSprite(sprite, source, dest, origin, 0.0f, WHITE);
 	}
 
 	Timer hitTimer;
 	int hitTime = 10;
 
-	bool hit;
-	Texture2D texture;
-
 private:
 
+	int x, y;
 	int width;
 	int height;
 
 	Vector2 GetColliderPosition() const
 	{
-		int x, y;
-		body->GetPhysicPosition(x, y);
 		return { (float)x, (float)y };
 	}
 
 	Vector2 GetTextureOrigin() const
 	{
 		// Adjust origin based on width and height to center the texture correctly
-		return { (float)(texture.width), (float)(texture.height / 2) };
+		return { GetSprite().rect.width, (float)((int)GetSprite().rect.height / 2) };
 	}
 };
 
-class Makuhita : PhysicEntity {
+class Makuhita : AnimatedEntity {
 public:
-	Makuhita(ModulePhysics* physics, int _x, int _y, Module* _listener, Texture2D _texture)
-		: PhysicEntity(physics->CreateRectangleSensor(_x + 29, _y + 35, 58, 70, b2_staticBody, NoInteraction), _listener)
-		, texture(_texture) {
+	Makuhita(ModulePhysics* physics, int _x, int _y, Module* _listener, const Animations& _animations, uint _animation)
+		: AnimatedEntity(physics->CreateRectangleSensor(_x + 29, _y + 35, 58, 70, b2_staticBody, NoInteraction), _listener, _animations, _animation) {
 		width = 29;
 		height = 20;
 	}
 
 	void Update() override
 	{
-
+		const Sprite& sprite = GetSprite();
 		Vector2 position = GetColliderPosition();
 		float scale = 2.0f;
 
-		Rectangle source = { 0.0f, 0.0f, (float)texture.width, (float)texture.height };
-		Rectangle dest = { position.x, position.y - (float)(height), (float)texture.width * scale, (float)texture.height * scale };
+		Rectangle source = { 0.0f, 0.0f, sprite.rect.width, sprite.rect.height };
+		Rectangle dest = { position.x, position.y - (float)(height), sprite.rect.width * scale, sprite.rect.height * scale };
 
 		Vector2 origin = GetTextureOrigin(); // Updated method to get the origin
 
 		float rotation = body->GetRotation() * RAD2DEG;
 
-		DrawTexturePro(texture, source, dest, origin, rotation, WHITE);
+		render->DrawSprite(sprite, source, dest, origin, rotation, WHITE);
 	}
 
 	int RayHit(vec2<int> ray, vec2<int> mouse, vec2<float>& normal) override
@@ -619,8 +329,6 @@ public:
 		return body->RayCast(ray.x, ray.y, mouse.x, mouse.y, normal.x, normal.y);
 	}
 
-	Texture2D texture;
-
 private:
 
 	int width;
@@ -636,33 +344,32 @@ private:
 	Vector2 GetTextureOrigin() const
 	{
 		// Adjust origin based on width and height to center the texture correctly
-		return { (float)(texture.width), (float)(texture.height / 2) };
+		return { GetSprite().rect.width, (float)((int)GetSprite().rect.height / 2) };
 	}
 };
 
-class Chikorita : PhysicEntity {
+class Chikorita : AnimatedEntity {
 public:
-	Chikorita(ModulePhysics* physics, int _x, int _y, Module* _listener, Texture2D _texture)
-		: PhysicEntity(physics->CreateRectangleSensor(_x + 19, _y + 43, 38, 86, b2_staticBody, NoInteraction), _listener)
-		, texture(_texture) {
+	Chikorita(ModulePhysics* physics, int _x, int _y, Module* _listener, const Animations& _animations, uint _animation)
+		: AnimatedEntity(physics->CreateRectangleSensor(_x + 19, _y + 43, 38, 86, b2_staticBody, NoInteraction), _listener, _animations, _animation) {
 		width = 19;
 		height = 20;
 	}
 
 	void Update() override
 	{
-
+		const Sprite& sprite = GetSprite();
 		Vector2 position = GetColliderPosition();
 		float scale = 2.0f;
 
-		Rectangle source = { 0.0f, 0.0f, (float)texture.width, (float)texture.height };
-		Rectangle dest = { position.x, position.y - (float)(height), (float)texture.width * scale, (float)texture.height * scale };
+		Rectangle source = { 0.0f, 0.0f, sprite.rect.width, sprite.rect.height };
+		Rectangle dest = { position.x, position.y - (float)(height), sprite.rect.width * scale, sprite.rect.height * scale };
 
 		Vector2 origin = GetTextureOrigin(); // Updated method to get the origin
 
 		float rotation = body->GetRotation() * RAD2DEG;
 
-		DrawTexturePro(texture, source, dest, origin, rotation, WHITE);
+		render->DrawSprite(sprite, source, dest, origin, rotation, WHITE);
 	}
 
 	int RayHit(vec2<int> ray, vec2<int> mouse, vec2<float>& normal) override
@@ -670,8 +377,6 @@ public:
 		return body->RayCast(ray.x, ray.y, mouse.x, mouse.y, normal.x, normal.y);
 	}
 
-	Texture2D texture;
-
 private:
 
 	int width;
@@ -687,7 +392,7 @@ private:
 	Vector2 GetTextureOrigin() const
 	{
 		// Adjust origin based on width and height to center the texture correctly
-		return { (float)(texture.width), (float)(texture.height / 2) };
+		return { GetSprite().rect.width, (float)((int)GetSprite().rect.height / 2) };
 	}
 };
 
@@ -699,15 +404,16 @@ public:
 	PhysBody* rightAnchor;
 	
 	
-	RightFlipper(ModulePhysics* physics, int _x, int _y, Module* _listener, const Texture2D& _texture)
+	RightFlipper(ModulePhysics* physics, int _x, int _y, int anchorX, int anchorY, Module* _listener, const Texture2D& _texture)
 		: PhysicEntity(physics->CreateRectangle(_x, _y, 60, 20, b2_dynamicBody, NoInteraction), _listener), texture(_texture)
 	{
 		// Initialize the bounding box based on the texture
 		width = 32;
 		height = 16;
 
-		rightAnchor = physics->CreateRectangle(305, 790, 1, 1, b2_staticBody, NoInteraction);
+		rightAnchor = physics->CreateRectangle(anchorX, anchorY, 1, 1, b2_staticBody, NoInteraction);
 		revJoint = physics->CreateFlipper(this->body, rightAnchor, b2Vec2(rightAnchor->body->GetPosition()));
+		physics->AddInterpolatedBody(this->body);
 	}
 
 	void Update() override
@@ -720,9 +426,9 @@ public:
 
 		Vector2 origin = GetTextureOrigin(); // Updated method to get the origin
 
-		float rotation = body->GetRotation() * RAD2DEG;
+		float rotation = body->GetRenderRotation() * RAD2DEG;
 		
-		DrawTexturePro(texture, source, dest, origin, rotation, WHITE);
+		render->DrawSprite(texture, source, dest, origin, rotation, WHITE, LAYER_FLIPPERS);
 	}
 
 	int RayHit(vec2<int> ray, vec2<int> mouse, vec2<float>& normal) override
@@ -739,7 +445,7 @@ private:
 	Vector2 GetColliderPosition() const
 	{
 		int x, y;
-		body->GetPhysicPosition(x, y);
+		body->GetRenderPosition(x, y);
 		return { (float)x, (float)y };
 	}
 
@@ -758,15 +464,16 @@ public:
 	b2RevoluteJoint* revJoint;
 	PhysBody* leftAnchor;
 
-	LeftFlipper(ModulePhysics* physics, int _x, int _y, Module* _listener, const Texture2D& _texture)
+	LeftFlipper(ModulePhysics* physics, int _x, int _y, int anchorX, int anchorY, Module* _listener, const Texture2D& _texture)
 		: PhysicEntity(physics->CreateRectangle(_x, _y, 60, 20, b2_dynamicBody, 1), _listener), texture(_texture)
 	{
 		// Initialize the bounding box based on the texture
 		width = 32;
 		height = 16;
 		
-		leftAnchor = physics->CreateRectangle(175, 790, 1, 1, b2_staticBody, NoInteraction);
+		leftAnchor = physics->CreateRectangle(anchorX, anchorY, 1, 1, b2_staticBody, NoInteraction);
 		revJoint = physics->CreateFlipper(this->body, leftAnchor, b2Vec2(leftAnchor->body->GetPosition()));
+		physics->AddInterpolatedBody(this->body);
 	}
 
 	void Update() override
@@ -779,9 +486,9 @@ public:
 
 		Vector2 origin = GetTextureOrigin(); // Updated method to get the origin
 
-		float rotation = body->GetRotation() * RAD2DEG;
+		float rotation = body->GetRenderRotation() * RAD2DEG;
 
-		DrawTexturePro(texture, source, dest, origin, rotation, WHITE);
+		render->DrawSprite(texture, source, dest, origin, rotation, WHITE, LAYER_FLIPPERS);
 	}
 
 	int RayHit(vec2<int> ray, vec2<int> mouse, vec2<float>& normal) override
@@ -797,7 +504,7 @@ private:
 	Vector2 GetColliderPosition() const
 	{
 		int x, y;
-		body->GetPhysicPosition(x, y);
+		body->GetRenderPosition(x, y);
 		return { (float)x, (float)y };
 	}
 
@@ -820,288 +527,241 @@ bool ModuleGame::Start()
 	LOG("Loading Intro assets");
 	bool ret = true;
 
-	// Font for interactive text
-	font = LoadFont("Assets/Ruby/Tiny5-Regular.ttf");
+	if (LoadTable(App->table_file) == false) return false;
 
-	// Load different textures
-	emptyBoard = LoadTexture("Assets/Ruby/bg+mart.png");
-	spoinkSheet = LoadTexture("Assets/Ruby/spoink_sheet.png");
-	pikachuSheet = LoadTexture("Assets/Ruby/pikachu_sheet.png");
-	palancaizqSheet = LoadTexture("Assets/Ruby/Left_Flipper.png");
-	palancaderSheet = LoadTexture("Assets/Ruby/Right_Flipper.png");
-	ballTex = LoadTexture("Assets/Ruby/temp ball.png");
-	gameOver = LoadTexture("Assets/Ruby/GAME OVER.png");
-	chinchouSheet = LoadTexture("Assets/Ruby/chinchou_sprite.png");
-	makuhitaSheet = LoadTexture("Assets/Ruby/makuhita_sheet/makuhita_idle1.png");
-
-	ballSave = LoadTexture("Assets/Ruby/ball_save.png");
-	ballSave.height = ballSave.height * 2;
-	ballSave.width = ballSave.width * 2;
-
-	ContactImpulserRight = LoadTexture("Assets/Ruby/ContactImpulserRight.png");
-	ContactImpulserRight.height = ContactImpulserRight.height * 2;
-	ContactImpulserRight.width = ContactImpulserRight.width * 2;
-
-	ContactImpulserLeft = LoadTexture("Assets/Ruby/ContactImpulserLeft.png");
-	ContactImpulserLeft.height = ContactImpulserLeft.height * 2;
-	ContactImpulserLeft.width = ContactImpulserLeft.width * 2;
-
-	// Loading textures into the array to generate an animation (Spoink)
-	frames[0] = LoadTexture("Assets/Ruby/spoink_sheet/spoink_sheet_1.png");
-	frames[1] = LoadTexture("Assets/Ruby/spoink_sheet/spoink_sheet_3.png");
-	frames[2] = LoadTexture("Assets/Ruby/spoink_sheet/spoink_sheet_4.png");
-	frames[3] = LoadTexture("Assets/Ruby/spoink_sheet/spoink_sheet_2.png");
-	frames[4] = LoadTexture("Assets/Ruby/spoink_sheet/spoink_sheet_1.png");
-
-	// Loading textures into the array to generate an animation (Spoink compress)
-	frames[5] = LoadTexture("Assets/Ruby/spoink_sheet_A/spoink_sheet_A_1.png");
-	frames[6] = LoadTexture("Assets/Ruby/spoink_sheet_A/spoink_sheet_A_2.png");
-	frames[7] = LoadTexture("Assets/Ruby/spoink_sheet_A/spoink_sheet_A_3.png");
-
-	// Loading textures into the array to generate an animation (Latios)
-	for (int z = 1;z < 14;z++)
+	// Plain text, the creatures look their clips up in headless runs too
+	if (animations.LoadClips("Assets/Ruby/animations.txt") == false) return false;
+
+	// Headless runs have no GPU or audio device to load assets into
+	if (!App->headless)
 	{
-		sprintf_s(cadena, "Assets/Ruby/ball_save/ball_save_%d.png", z);
-		frames_Latios[z] = LoadTexture(cadena);
-		frames_Latios[z].height = frames_Latios[z].height * 2;
-		frames_Latios[z].width = frames_Latios[z].width * 2;
+		ret = LoadAssets();
 	}
 
-	// Loading textures into the array to generate an animation (Pikachu)
-	frames_pikachu[0] = LoadTexture("Assets/Ruby/pikachu_sheet/pikachu_sheet_1.png");
-	frames_pikachu[1] = LoadTexture("Assets/Ruby/pikachu_sheet/pikachu_sheet_2.png");
+	state = State::INGAME;
 
-	// Loading textures into the array to generate an animation (Chinchou)
-	frames_chinchou_idle[0] = LoadTexture("Assets/Ruby/chinchou_sheet/chinchou_idle1.png");
-	frames_chinchou_idle[1] = LoadTexture("Assets/Ruby/chinchou_sheet/chinchou_idle2.png");
+	return ret;
+}
 
-	// Loading textures into the array to generate an animation (Chinchou hit)
-	frames_chinchou_hit[0] = LoadTexture("Assets/Ruby/chinchou_sheet/chinchou_hit1.png");
-	frames_chinchou_hit[1] = LoadTexture("Assets/Ruby/chinchou_sheet/chinchou_hit2.png");
+void ModuleGame::CreateEntities()
+{
+	spoinkIdleClip = animations.FindClip("spoink_idle");
+	spoinkChargeClip = animations.FindClip("spoink_charge");
+	chinchouHitClip = animations.FindClip("chinchou_hit");
+
+	pikachuAnimation = animations.Add(animations.FindClip("pikachu_idle"));
+	latiosAnimation = animations.Add(animations.FindClip("latios"));
+
+	// Generate all Pkmn and objects where the table places them
+	int x, y, anchorX, anchorY;
+
+	table.GetSpawn("pikachu_right", x, y);
+	pikachu = new Pikachu(App->physics, x, y, this, animations, pikachuAnimation);
+	table.GetSpawn("makuhita", x, y);
+	makuhita = new Makuhita(App->physics, x, y, this, animations, animations.Add(animations.FindClip("makuhita_idle")));
+	table.GetSpawn("chikorita", x, y);
+	chikorita = new Chikorita(App->physics, x, y, this, animations, animations.Add(animations.FindClip("chikorita_idle")));
+	chinchou1 = new Chinchou(table.GetBumper(0), this, animations, animations.Add(animations.FindClip("chinchou_idle")));
+	chinchou2 = new Chinchou(table.GetBumper(1), this, animations, animations.Add(animations.FindClip("chinchou_idle")));
+	chinchou3 = new Chinchou(table.GetBumper(2), this, animations, animations.Add(animations.FindClip("chinchou_idle")));
+
+	table.GetSpawn("flipper_right", x, y);
+	table.GetSpawn("anchor_right", anchorX, anchorY);
+	rFlip = new RightFlipper(App->physics, x, y, anchorX, anchorY, this, palancaderSheet);
+	table.GetSpawn("flipper_left", x, y);
+	table.GetSpawn("anchor_left", anchorX, anchorY);
+	lFlip = new LeftFlipper(App->physics, x, y, anchorX, anchorY, this, palancaizqSheet);
+
+	// Walls, sensors and bumpers
+	rubyBoard = new Board(App->physics, table, this, emptyBoard);
+	rubyBoard->changeColision(false);
+
+	table.GetSpawn("spoink", x, y);
+	spoink = new Spring(App->physics, x, y, this, animations, animations.Add(spoinkIdleClip));
+
+	table.GetSpawn("ball", x, y);
+	initBallPos = { (float)x, (float)y };
+	table.GetSpawn("multiball", multiballPos.x, multiballPos.y);
+	table.GetSpawn("pikachu_right", pikachuRight.x, pikachuRight.y);
+	table.GetSpawn("pikachu_left", pikachuLeft.x, pikachuLeft.y);
+}
 
-	// Loading textures into the array to generate an animation (Makuhita)
-	frames_makuhita_idle[0] = LoadTexture("Assets/Ruby/makuhita_sheet/makuhita_idle1.png");
-	frames_makuhita_idle[1] = LoadTexture("Assets/Ruby/makuhita_sheet/makuhita_idle2.png");
+// Entities are placed from the table, it has to hold every part the game expects
+bool ModuleGame::LoadTable(const char* path)
+{
+	if (table.Load(path) == false) return false;
 
-	// Loading textures into the array to generate an animation (Chikorita)
-	frames_chikorita_idle[0] = LoadTexture("Assets/Ruby/chikorita_sheet/chikorita_idle1.png");
-	frames_chikorita_idle[1] = LoadTexture("Assets/Ruby/chikorita_sheet/chikorita_idle2.png");
+	if (table.FindChain(TABLE_CHAIN_BOARD) == NULL || table.GetBumperCount() < 3)
+	{
+		LOG("Table %s needs a board chain and 3 bumpers", path);
+		table.Unload();
+		return false;
+	}
 
-	// Loading textures into the array to generate an animation and size adjustment (Win)
-	frames_Win[0] = LoadTexture("Assets/Ruby/win_1.png");
-	frames_Win[0].height = frames_Win[0].height * 2;
-	frames_Win[0].width = frames_Win[0].width * 2;
-
-	frames_Win[1] = LoadTexture("Assets/Ruby/win_2.png");
-	frames_Win[1].height = frames_Win[1].height * 2;
-	frames_Win[1].width = frames_Win[1].width * 2;
-
-	// Generate all Pkmn and objects
-	pikachu = new Pikachu(App->physics, 415, 775, this, pikachuSheet);
-	makuhita = new Makuhita(App->physics, 386, 546, this, makuhitaSheet);
-	chikorita = new Chikorita(App->physics, 110, 434, this, chikoritaSheet);
-	chinchou1 = new Chinchou(App->physics, 292, 270, this, chinchouSheet, Chinchou1Bumper);
-	chinchou2 = new Chinchou(App->physics, 256, 306, this, chinchouSheet, Chinchou2Bumper);
-	chinchou3 = new Chinchou(App->physics, 308, 320, this, chinchouSheet, Chinchou3Bumper);
-
-	rFlip = new RightFlipper(App->physics, 280, 790, this, palancaderSheet);
-	lFlip = new LeftFlipper(App->physics, 200, 790, this, palancaizqSheet);
-
-	blocker = new Block(App->physics, 198, 798, this, emptyBoard);
-	blocker->changeColision(false);
-
-	rubyBoard = new Board(App->physics, 0, 0, this, emptyBoard);
-	rubyObstacle = new Obstacle(App->physics, 0, 0, this, emptyBoard);
-
-	spoink = new Spring(App->physics, 472, 775, this, spoinkSheet);
-
-	// Sensors
-	sensorBlock = App->physics->CreateRectangleSensor(360, 200, 20, 50, b2_staticBody, startBlocker);
-	sensor = App->physics->CreateRectangleSensor(65, 780, 30, 20, b2_staticBody, Impulser);
-	sensor = App->physics->CreateRectangleSensor(275, 210, 120, 10, b2_staticBody, Points); //Top points
-	sensor = App->physics->CreateRectangleSensor(390, 705, 80, 20, b2_staticBody, Points);  //Left points
-	sensor = App->physics->CreateRectangleSensor(90, 705, 80, 20, b2_staticBody, Points);   //Right points
-	sensor = App->physics->CreateRectangleSensor(242, 850, 82, 10, b2_staticBody, Dead);  
-
-	// Music and sound effects
-	music = LoadMusicStream("Assets/Ruby/Music Tracks/RedTableTrack.mp3");
-	gameOverMusic = LoadSound("Assets/Ruby/Music Tracks/Game Over.mp3");
-	winMusic = LoadSound("Assets/Ruby/Music Tracks/You Win.mp3");
-	extraLifeSound = LoadSound("Assets/Ruby/Sounds/Dorodo.WAV");
-
-	pointsSFX = LoadSound("Assets/Ruby/Sounds/Another pling.WAV");
-	deadSFX = LoadSound("Assets/Ruby/Sounds/DOOoo.WAV");
-	impulserSFX = LoadSound("Assets/Ruby/Sounds/bumpers.wav");
-
-	flipperFX = App->audio->LoadFx("Assets/Ruby/Sounds/flipperFX.mp3");
-	spoink_chargeSFX = App->audio->LoadFx("Assets/Ruby/Sounds/spoink_charge.wav");
-	spoink_releaseSFX = App->audio->LoadFx("Assets/Ruby/Sounds/spoink_release.wav");
-
-	chinchou_hitSFX = App->audio->LoadFx("Assets/Ruby/Sounds/chinchou_hit.wav");
-
-	// Music settings
-	SetMusicVolume(music, 0.4f);
-	SetSoundVolume(extraLifeSound, 2.0f);
-
-	if (music.stream.buffer == NULL) 
+	return true;
+}
+
+// The ball left from the last life goes back to the launch lane, -balls adds the rest around the multiball spawn
+// Rows that do not fit start above the table and drop in, its walls only stop balls from the inside
+void ModuleGame::ServeBalls()
+{
+	if (balls.empty())
 	{
-		LOG("Error loading music stream");
-		ret = false;
+		AddBall((int)initBallPos.x, (int)initBallPos.y);
 	}
 	else
 	{
-		PlayMusicStream(music);
+		balls[0].body->body->SetTransform(b2Vec2(PIXEL_TO_METERS(initBallPos.x), PIXEL_TO_METERS(initBallPos.y)), 0.0f);
+		balls[0].body->ResetInterpolation();
+		balls[0].drained = false;
+		balls[0].served = gameTicks;
 	}
-	
-	if (gameOverMusic.stream.buffer == NULL)
+
+	for (uint i = 1; i < App->ball_count; ++i)
 	{
-		LOG("Error loading gameOverMusic stream");
-		ret = false;
+		int column = (i - 1) % MULTIBALL_COLUMNS;
+		int row = (i - 1) / MULTIBALL_COLUMNS;
+		AddBall(multiballPos.x + (2 * column - (MULTIBALL_COLUMNS - 1)) * MULTIBALL_SPACING / 2, multiballPos.y - row * MULTIBALL_SPACING);
 	}
+}
 
-	state = State::INGAME;
-
+void ModuleGame::AddBall(int x, int y)
+{
+	PhysBody* body = App->physics->CreateBall(x, y, 10);
+	body->listener = this;
+	App->physics->AddInterpolatedBody(body);
 
-	return ret;
+	balls.push_back(BallState{ body, false, gameTicks });
 }
 
-update_status ModuleGame::Update()
+// A drained ball is taken off while others are still in play, losing the last one costs a life
+void ModuleGame::RemoveDrainedBalls()
 {
-	switch (state)
+	for (uint i = 0; i < balls.size();)
 	{
-	case State::INGAME:
-		
-		UpdateMusicStream(music);
-
-		rubyBoard->Update();
-		rubyObstacle->Update();
-		chikorita->Update();
-
-
-		if(start && !oneTime)
-		{ 
-			blocker->changeColision(true);
-			oneTime = true;
-		}
-
-		if (ball == NULL) {
-			ball = new Ball(App->physics, initBallPos.x, initBallPos.y, this, ballTex);
-		}
-
-		// Animation Pikachu
-		timer_pikachu += GetFrameTime();
-		if (timer_pikachu >= frameTime_pikachu)
+		if (balls[i].drained == false)
 		{
-			timer_pikachu = 0.0f;
-			currentFrame_pikachu++;
-			if (currentFrame_pikachu >= 2) currentFrame_pikachu = 0;	// RESET 
+			++i;
+			continue;
 		}
-		pikachu->texture = frames_pikachu[currentFrame_pikachu];
 
-		// Animation Spoink
-		timer += GetFrameTime();
+		drainedBalls++;
+		ballLifeTicks += gameTicks - balls[i].served;
 
-		if(!changeAnimation) {
-			if (timer >= frameTime) {
-				timer = 0.0f;
-				currentFrame++;
-				if (currentFrame >= 5) currentFrame = 0; // RESET
-			}
+		if (balls.size() == 1)
+		{
+			balls[i].drained = false;
+			dead = true;
+			break;
 		}
 		else
 		{
-			if (timer >= frameTime) {
-				timer = 0.0f;
-				currentFrame++;
-				if (currentFrame >= 7) currentFrame = 5; // RESET
-			}
+			App->physics->DestroyBody(balls[i].body);
+			balls[i] = balls.back();
+			balls.pop_back();
 		}
+	}
+}
 
-		spoink->texture = frames[currentFrame];
+int ModuleGame::FindBall(const PhysBody* body) const
+{
+	for (uint i = 0; i < balls.size(); ++i)
+	{
+		if (balls[i].body == body) return (int)i;
+	}
 
-		// Animation Chinchou
-		timer_chinchou += GetFrameTime();
-		if (timer_chinchou >= frameTime_chinchou)
-		{
-			timer_chinchou = 0.0f;
-			currentFrame_chinchou++;
-			if (currentFrame_chinchou >= 2)currentFrame_chinchou = 0; // RESET
-		}
+	return -1;
+}
 
-		// Change animation if Chinchou 1 is hitted
-		if (chinchou1->hit) {
-			chinchou1->texture = frames_chinchou_hit[currentFrame_chinchou];
-			
-			cntAnimation++;
-			if (cntAnimation == 35){
-				chinchou1->hit= false;
-				cntAnimation = 0;
-			}
-		}
-		else {
-			chinchou1->texture = frames_chinchou_idle[currentFrame_chinchou]; // Chinchou 1 idle animation
-		}
+// Images and sounds are decoded on the asset loader threads, the game starts once the required ones are uploaded
+bool ModuleGame::LoadAssets()
+{
+	bool ret = true;
 
-		// Change animation if Chinchou 2 is hitted
-		if (chinchou2->hit) {
-			chinchou2->texture = frames_chinchou_hit[currentFrame_chinchou];
+	// Font for interactive text
+	font = LoadFont("Assets/Ruby/Tiny5-Regular.ttf");
 
-			cntAnimation++;
-			if (cntAnimation == 35) {
-				chinchou2->hit = false;
-				cntAnimation = 0;
-			}
-		}
-		else {
-			chinchou2->texture = frames_chinchou_idle[currentFrame_chinchou]; // Chinchou 2 idle animation
-		}
+	// Textures needed to draw the table
+	App->assets->QueueTexture(table.GetTexture(), &emptyBoard, ASSET_REQUIRED);
+	App->assets->QueueTexture("Assets/Ruby/Left_Flipper.png", &palancaizqSheet, ASSET_REQUIRED);
+	App->assets->QueueTexture("Assets/Ruby/Right_Flipper.png", &palancaderSheet, ASSET_REQUIRED);
+	App->assets->QueueTexture("Assets/Ruby/temp ball.png", &ballTex, ASSET_REQUIRED);
 
-		// Change animation if Chinchou 3 is hitted
-		if (chinchou3->hit) {
-			chinchou3->texture = frames_chinchou_hit[currentFrame_chinchou];
+	App->assets->QueueTexture("Assets/Ruby/ContactImpulserRight.png", &ContactImpulserRight, ASSET_REQUIRED, 2);
+	App->assets->QueueTexture("Assets/Ruby/ContactImpulserLeft.png", &ContactImpulserLeft, ASSET_REQUIRED, 2);
 
-			cntAnimation++;
-			if (cntAnimation == 35) {
-				chinchou3->hit = false;
-				cntAnimation = 0;
-			}
-		}
-		else {
-			chinchou3->texture = frames_chinchou_idle[currentFrame_chinchou];  // Chinchou 3 idle animation
-		}
+	// Animation frames, packed into the sprite atlas
+	animations.QueueFrames(App->assets);
+	App->assets->QueueAtlas(ASSET_REQUIRED);
 
-		// Animation Makuhita
-		timer_makuhita += GetFrameTime();
-		if (timer_makuhita >= frameTime_makuhita)
-		{
-			timer_makuhita = 0.0f;
-			currentFrame_makuhita++;
-			if (currentFrame_makuhita >= 2) currentFrame_makuhita = 0;		// RESET
+	// Only shown after losing a ball or at the end of the game, these can arrive later
+	App->assets->QueueTexture("Assets/Ruby/GAME OVER.png", &gameOver, ASSET_DEFERRED);
+	App->assets->QueueTexture("Assets/Ruby/ball_save.png", &ballSave, ASSET_DEFERRED, 2);
 
-		}
-		makuhita->texture = frames_makuhita_idle[currentFrame_makuhita];
+	// Loading textures into the array to generate an animation and size adjustment (Win)
+	App->assets->QueueTexture("Assets/Ruby/win_1.png", &frames_Win[0], ASSET_DEFERRED, 2);
+	App->assets->QueueTexture("Assets/Ruby/win_2.png", &frames_Win[1], ASSET_DEFERRED, 2);
 
-		timer_chikorita += GetFrameTime();
-		if (timer_chikorita >= frameTime_chikorita)
-		{
-			timer_chikorita = 0.0f;
-			currentFrame_chikorita++;
-			if (currentFrame_chikorita >= 2) currentFrame_chikorita = 0;	// RESET
+	// Sound effects, silent until they are loaded
+	App->assets->QueueFx("Assets/Ruby/Music Tracks/Game Over.mp3", &gameOverMusic, ASSET_DEFERRED);
+	App->assets->QueueFx("Assets/Ruby/Music Tracks/You Win.mp3", &winMusic, ASSET_DEFERRED);
+	App->assets->QueueFx("Assets/Ruby/Sounds/Dorodo.WAV", &extraLifeSound, ASSET_DEFERRED, 2.0f);
+
+	App->assets->QueueFx("Assets/Ruby/Sounds/Another pling.WAV", &pointsSFX, ASSET_DEFERRED);
+	App->assets->QueueFx("Assets/Ruby/Sounds/DOOoo.WAV", &deadSFX, ASSET_DEFERRED);
+	App->assets->QueueFx("Assets/Ruby/Sounds/bumpers.wav", &impulserSFX, ASSET_DEFERRED);
+
+	App->assets->QueueFx("Assets/Ruby/Sounds/flipperFX.mp3", &flipperFX, ASSET_DEFERRED);
+	App->assets->QueueFx("Assets/Ruby/Sounds/spoink_charge.wav", &spoink_chargeSFX, ASSET_DEFERRED);
+	App->assets->QueueFx("Assets/Ruby/Sounds/spoink_release.wav", &spoink_releaseSFX, ASSET_DEFERRED);
+
+	App->assets->QueueFx("Assets/Ruby/Sounds/chinchou_hit.wav", &chinchou_hitSFX, ASSET_DEFERRED);
+
+	// Music settings, the stream is decoded while it plays so it can start right away
+	if (App->audio->PlayMusic("Assets/Ruby/Music Tracks/RedTableTrack.mp3") == false)
+	{
+		LOG("Error loading music stream");
+		ret = false;
+	}
+
+	App->audio->SetMusicVolume(0.4f);
+
+	return ret;
+}
+
+// Game rules, run right after the physics step
+update_status ModuleGame::PreUpdate()
+{
+	// The table is built on the first tick, once the textures it is drawn with are uploaded
+	if (rubyBoard == NULL)
+	{
+		CreateEntities();
+	}
+
+	switch (state)
+	{
+	case State::INGAME:
 
+		gameTicks++;
+
+		if(start && !oneTime)
+		{
+			rubyBoard->changeColision(true);
+			oneTime = true;
 		}
-		chikorita->texture = frames_chikorita_idle[currentFrame_chikorita];
+
+		if (balls.empty()) ServeBalls();
+
+		// Collisions of this tick are in, drained balls leave the table
+		RemoveDrainedBalls();
 
 		// Puntuation rewards
-		if (player.actualScore >= 1000 && !extralife) {
+		if (player.actualScore >= App->tuning.extra_life_score && !extralife) {
 
 			if(textCounter == 0){
 				player.lifes += 1;
-				PlaySound(extraLifeSound);
+				App->audio->PlayFx(extraLifeSound);
 			}
-			else if (textCounter <=25 || textCounter >= 50 && textCounter <= 75 || textCounter >= 100 && textCounter <= 125 || textCounter >= 150 && textCounter <= 175) 
-				DrawTextEx(font, "EXTRA LIFE!", { 150, 440 }, 35, 5, RED);
-
-			else  DrawTextEx(font, "EXTRA LIFE!", { 150, 440 }, 35, 5, ORANGE);
 			if (textCounter == 160) {
 				extralife = true;
 				textCounter = 0;
@@ -1111,35 +771,33 @@ update_status ModuleGame::Update()
 
 		// Impulser types
 		if (canImpulse) {
-			
-			DrawRectangle(0, 440, 700, 25, WHITE);
-			DrawTextEx(font, "Hold/release DOWN arrow to shoot!", { 100, 440 }, 25, 0, BLACK);
 
 			if (basicImpulser) // Lateral impulsers (Pikachu) 
 			{
-				if (IsKeyReleased(KEY_DOWN)) {
+				if (App->input->IsKeyReleased(KEY_DOWN)) {
 					// Apply a force to the plunger when the key DOWN is pressed
 					b2Vec2 force(0.0f, -0.7f);
-					ball->ShootBall(force);
+					PhysBody* kicked = App->physics->GetBody(impulseBall);
+					if (kicked != NULL) kicked->body->ApplyLinearImpulseToCenter(force, true);
 					canImpulse = false;
 					basicImpulser = false;
 				}
 			}
 			else // Impulsor (Spoink)
 			{
-				if (IsKeyPressed(KEY_DOWN)) {
+				if (App->input->IsKeyPressed(KEY_DOWN)) {
 					App->audio->PlayFx(spoink_chargeSFX);
 				}
 
-				if (IsKeyDown(KEY_DOWN)){ 
-					changeAnimation = true;
+				if (App->input->IsKeyDown(KEY_DOWN)){
+					animations.Play(spoink->animation, spoinkChargeClip);
 					spoink->joint->SetMotorSpeed(-0.5f);
 				}
 
-				else if (IsKeyReleased(KEY_DOWN))
+				else if (App->input->IsKeyReleased(KEY_DOWN))
 				{
 					App->audio->PlayFx(spoink_releaseSFX);
-					changeAnimation = false;
+					animations.Play(spoink->animation, spoinkIdleClip);
 					spoink->joint->SetMotorSpeed(200.0f);
 					canImpulse = false;
 				}
@@ -1160,68 +818,153 @@ update_status ModuleGame::Update()
 
 		// Flipper movement
 
-		if (IsKeyPressed(KEY_RIGHT)) {
+		if (App->input->IsKeyPressed(KEY_RIGHT)) {
 			App->audio->PlayFx(flipperFX);
-			pikachu = new Pikachu(App->physics, 415, 775, this, pikachuSheet);
+			pikachu->MoveTo(pikachuRight.x, pikachuRight.y);
 			rFlip->revJoint->SetMotorSpeed(-4.0f);
 			
 		}
-		else if (IsKeyReleased(KEY_RIGHT)) {
+		else if (App->input->IsKeyReleased(KEY_RIGHT)) {
 			rFlip->revJoint->SetMotorSpeed(4.0f);
 			
 		}
 
-		if (IsKeyPressed(KEY_LEFT)) {
+		if (App->input->IsKeyPressed(KEY_LEFT)) {
 			App->audio->PlayFx(flipperFX);
-			pikachu = new Pikachu(App->physics, 66, 775, this, pikachuSheet);
+			pikachu->MoveTo(pikachuLeft.x, pikachuLeft.y);
 			lFlip->revJoint->SetMotorSpeed(4.0f);
 		}
-		else if (IsKeyReleased(KEY_LEFT)) {
+		else if (App->input->IsKeyReleased(KEY_LEFT)) {
 			lFlip->revJoint->SetMotorSpeed(-4.0f);
 		}
 
 		// Lifes management
 		if (dead) {
 			if (cnt < 1500 && player.lifes != 1){
-				if(cnt == 0)PlaySound(deadSFX);
-				
-				// Latios animation and trigger
-				if (cnt<=150 || cnt >= 1200){
-					DrawTexture(ballSave, cntAnimation, 450, WHITE);
-					cntAnimation += 5;
-				}
-				else
-				{
-					timer_latios += GetFrameTime();
-					if (timer_latios >= framesTime_latios)
-					{
-						timer_latios = 0.0f;
-						if(backwards)currentFrames_latios--;
-						else currentFrames_latios++;
-						if (currentFrames_latios >= 13) backwards = true;
-						else if (currentFrames_latios <= 2) backwards = false;	// Restart cicle
-					}
-					DrawTexture(frames_Latios[currentFrames_latios], 150, 450, WHITE);
-				}
+				if(cnt == 0) App->audio->PlayFx(deadSFX);
 				cnt +=5;
 			}
 			else // Reset variables
 			{ 
-				ball->updatePosition();
+				ServeBalls();
 				player.lifes -= 1;
 				oneTime = false;
 				start = false;
-				blocker->changeColision(false);
+				rubyBoard->changeColision(false);
 				dead = false;
 				cntAnimation = 0;
 				cnt = 0;
 			}
 		}
+
+		// Win/Lose condition
+		if (player.lifes == 0)
+		{
+
+			App->audio->StopMusic();
+
+			if(player.actualScore < player.bestScore || player.actualScore == 0){
+				App->audio->PlayFx(gameOverMusic);
+				state = State::DEAD;
+			}
+			else {
+				App->audio->PlayFx(winMusic);
+				state = State::WIN;
+			}
+		}
+
+		break;
+
+	case State::DEAD:
+
+		if (App->input->IsKeyPressed(KEY_SPACE)) {
+			state = State::SCORE;
+			player.lifes = 3;
+			cnt = 0;
+		}
+
+		break;
+
+	case State::SCORE:
+		// Score update
+		if (player.actualScore > player.bestScore){
+			player.bestScore = player.actualScore;
+		}
+
+		player.actualScore = 0;
+
+		App->audio->StopFx(gameOverMusic);
+		App->audio->RestartMusic();
+
+		state = State::INGAME;
+		break;
+
+	case State::WIN:
+
+		if (App->input->IsKeyPressed(KEY_SPACE)) {
+			App->audio->StopFx(winMusic);
+			state = State::SCORE;
+			player.lifes = 3;
+			cnt = 0;
+		}
+
+		break;
+	default:
+		break;
+	}
+
+	return UPDATE_CONTINUE;
+}
+
+// Animations and drawing, the game rules live in PreUpdate()
+update_status ModuleGame::Update()
+{
+	if (App->headless)
+	{
+		return UPDATE_CONTINUE;
+	}
+
+	switch (state)
+	{
+	case State::INGAME:
+
+		// Every creature animation moves forward in one pass
+		animations.Advance(App->dt);
+
+		rubyBoard->Update();
+		chikorita->Update();
+
+		// Extra life text
+		if (player.actualScore >= App->tuning.extra_life_score && !extralife) {
+			if (textCounter <=25 || textCounter >= 50 && textCounter <= 75 || textCounter >= 100 && textCounter <= 125 || textCounter >= 150 && textCounter <= 175)
+				App->renderer->DrawText("EXTRA LIFE!", { 150, 440 }, font, 35, 5, RED);
+
+			else  App->renderer->DrawText("EXTRA LIFE!", { 150, 440 }, font, 35, 5, ORANGE);
+		}
+
+		// Impulser help
+		if (canImpulse) {
+
+			App->renderer->DrawRectangle({ 0, 440, 700, 25 }, WHITE);
+			App->renderer->DrawText("Hold/release DOWN arrow to shoot!", { 100, 440 }, font, 25, 0, BLACK);
+		}
+
+		if (dead) {
+			// Latios animation and trigger
+			if (cnt<=150 || cnt >= 1200){
+				App->renderer->Draw(ballSave, cntAnimation, 450);
+				cntAnimation += 5;
+			}
+			else
+			{
+				App->renderer->Draw(animations.GetFrame(latiosAnimation), 150, 450);
+			}
+		}
 		else // Impulser block
 		{
 			if (contactLeft && cnt < 12)
 			{
-				DrawTexture(ContactImpulserLeft, 130, 660, WHITE);
+				App->renderer->Draw(ContactImpulserLeft, 130, 660, LAYER_ENTITIES);
 				cnt++;
 			}
 			else if (!contactRight) {
@@ -1231,7 +974,7 @@ update_status ModuleGame::Update()
 
 			if (contactRight && cnt < 12)
 			{
-				DrawTexture(ContactImpulserRight, 305, 660, WHITE);
+				App->renderer->Draw(ContactImpulserRight, 305, 660, LAYER_ENTITIES);
 				cnt++;
 			}
 			else if (!contactLeft) {
@@ -1240,22 +983,6 @@ update_status ModuleGame::Update()
 			}
 		}
 
-		// Win/Lose condition
-		if (player.lifes == 0) 
-		{ 
-
-			StopMusicStream(music);
-
-			if(player.actualScore < player.bestScore || player.actualScore == 0){
-				PlaySound(gameOverMusic);
-				state = State::DEAD;
-			}
-			else {
-				PlaySound(winMusic);
-				state = State::WIN;
-			}
-		}
-
 		// Updates
 		pikachu->Update();
 		spoink->Update();
@@ -1265,15 +992,25 @@ update_status ModuleGame::Update()
 		chinchou3->Update();
 
 		makuhita->Update();
-		ball->Update();
+
+		for (const BallState& ball : balls)
+		{
+			int x, y;
+			ball.body->GetRenderPosition(x, y);
+			float scale = 2.0f;
+			Rectangle source = { 0.0f, 0.0f, (float)ballTex.width, (float)ballTex.height };
+			Rectangle dest = { (float)x, (float)y, (float)ballTex.width * scale, (float)ballTex.height * scale };
+			Vector2 origin = { (float)(ballTex.width * scale / 2), (float)(ballTex.height * scale / 2) };
+			App->renderer->DrawSprite(ballTex, source, dest, origin, ball.body->GetRenderRotation() * RAD2DEG, WHITE, LAYER_BALL);
+		}
 
 		// Scores render
 		sprintf_s(cadena, "%d", player.actualScore);
-		DrawTextEx(font, cadena, { 410, 822}, 30,0, WHITE);
+		App->renderer->DrawText(cadena, { 410, 822}, font, 30,0, WHITE);
 
 		sprintf_s(cadena, "%d", player.bestScore);
-		DrawTextEx(font, cadena, { 410, 805 }, 25, 0, YELLOW);
-		DrawTextEx(font, "BEST:", { 360, 808 }, 20, 0, YELLOW);
+		App->renderer->DrawText(cadena, { 410, 805 }, font, 25, 0, YELLOW);
+		App->renderer->DrawText("BEST:", { 360, 808 }, font, 20, 0, YELLOW);
 
 		break;
 
@@ -1281,35 +1018,15 @@ update_status ModuleGame::Update()
 
 		rubyBoard->Update();
 
-		DrawTexture(gameOver,40, 400, WHITE);
+		App->renderer->Draw(gameOver, 40, 400);
 
 		// Text flashing
 		if (cnt >= 20) {
-			DrawTextEx(font, "PRESS SPACE TO CONTINUE", { 100, 440 }, 25, 0, BLACK);
+			App->renderer->DrawText("PRESS SPACE TO CONTINUE", { 100, 440 }, font, 25, 0, BLACK);
 		}
 		if (cnt >= 80) cnt = 0;
 		cnt++;
 
-		if (IsKeyPressed(KEY_SPACE)) {
-			state = State::SCORE;
-			player.lifes = 3;
-			cnt = 0;
-		}
-
-		break;
-
-	case State::SCORE:
-		// Score update
-		if (player.actualScore > player.bestScore){
-			player.bestScore = player.actualScore;
-		}
-	
-		player.actualScore = 0;
-
-		StopSound(gameOverMusic);
-		PlayMusicStream(music);
-
-		state = State::INGAME;
 		break;
 
 	case State::WIN:
@@ -1322,35 +1039,28 @@ update_status ModuleGame::Update()
 		if (cnt >= 20) 
 		{
 			
-			DrawTexture(frames_Win[0], 40, 400, WHITE);
+			App->renderer->Draw(frames_Win[0], 40, 400);
 
-			DrawTextEx(font, cadena, { 120, 600 }, 35, 0, ORANGE);
+			App->renderer->DrawText(cadena, { 120, 600 }, font, 35, 0, ORANGE);
 		}
 		else{
-			DrawTexture(frames_Win[1], 40, 400, WHITE);
+			App->renderer->Draw(frames_Win[1], 40, 400);
 
-			DrawTextEx(font, cadena, { 120, 600 }, 35, 0, YELLOW);
+			App->renderer->DrawText(cadena, { 120, 600 }, font, 35, 0, YELLOW);
 		}
 
 		if (cnt >= 40) cnt = 0;
 		cnt++;
 
-		if (IsKeyPressed(KEY_SPACE)) {
-			StopSound(winMusic);
-			state = State::SCORE;
-			player.lifes = 3;
-			cnt = 0;
-		}
-
 		break;
 	default:
 		break;
 	}
 
 	// Lifes render
-	DrawTexture(ballTex, 60, 825, WHITE);
+	App->renderer->Draw(ballTex, 60, 825);
 	sprintf_s(cadena, "%d", player.lifes);
-	DrawTextEx(font, cadena, { 80, 820 }, 25, 0, WHITE);
+	App->renderer->DrawText(cadena, { 80, 820 }, font, 25, 0, WHITE);
 
 	// Always on update
 	rFlip->Update();
@@ -1359,8 +1069,6 @@ update_status ModuleGame::Update()
 	pikachu->Update();
 	spoink->Update();
 
-	UpdateMusicStream(music);
-
 	return UPDATE_CONTINUE;
 }
 
@@ -1368,21 +1076,27 @@ void ModuleGame::OnCollision(PhysBody* bodyA, PhysBody* bodyB, int dir)
 {	
 	b2Vec2 force(0.0f, 0.0f);
 
+	// The ball can be either body, sensors and the table report with themselves as bodyA
+	int index = FindBall(bodyA);
+	if (index < 0) index = FindBall(bodyB);
+	BallState* ball = (index >= 0) ? &balls[index] : NULL;
+
 	// Different types of response depending on what you collide with
 
 	if (dir == SpringImpulser || dir == PikachuImpulser || dir == Impulser){
 		canImpulse = true;
 		if (dir == PikachuImpulser || dir == Impulser) basicImpulser = true;
+		if (ball != NULL) impulseBall = ball->body->handle;
 	}
 
 	if (dir == LeftImpulser){
-		PlaySound(impulserSFX);
+		App->audio->PlayFx(impulserSFX);
 		contactLeft = true;
 		force = { 0.4f, -0.9f };
 	}
 
 	else if (dir == RightImpulser){ 
-		PlaySound(impulserSFX);
+		App->audio->PlayFx(impulserSFX);
 		contactRight = true;
 		force = { -0.4f, -0.9f };
 	}
@@ -1391,9 +1105,9 @@ void ModuleGame::OnCollision(PhysBody* bodyA, PhysBody* bodyB, int dir)
 		player.actualScore += 100;
 		canImpulse = false;
 		basicImpulser = false;
-		PlaySound(pointsSFX);
+		App->audio->PlayFx(pointsSFX);
 	}
-	else if (dir == Dead) dead = true;
+	else if (dir == Dead && ball != NULL) ball->drained = true;
 
 	if (dir == SpringImpulser) {
 		canImpulse = true;
@@ -1401,24 +1115,24 @@ void ModuleGame::OnCollision(PhysBody* bodyA, PhysBody* bodyB, int dir)
 
 	if (dir == 10 && start == false) start = true;
 
-	// Force to shoot the ball
-	ball->ShootBall(force);
+	// Force to shoot the ball that collided
+	if (ball != NULL) ball->body->body->ApplyLinearImpulseToCenter(force, true);
 
 	bumper_hit = true;
 
 	if (dir == Chinchou1Bumper) {
 		App->audio->PlayFx(chinchou_hitSFX);
-		chinchou1->hit = true;
+		animations.Play(chinchou1->animation, chinchouHitClip, true);
 	}
 
 	if (dir == Chinchou2Bumper) {
 		App->audio->PlayFx(chinchou_hitSFX);
-		chinchou2->hit = true;
+		animations.Play(chinchou2->animation, chinchouHitClip, true);
 	}
 
 	if (dir == Chinchou3Bumper) {
 		App->audio->PlayFx(chinchou_hitSFX);
-		chinchou3->hit = true;
+		animations.Play(chinchou3->animation, chinchouHitClip, true);
 	}
 	
 }
@@ -1428,28 +1142,23 @@ bool ModuleGame::CleanUp()
 {
 	LOG("Unloading Intro scene");
 
-	UnloadTexture(emptyBoard);
-	UnloadTexture(ballTex);
-	UnloadTexture(spoinkSheet);
-	UnloadTexture(pikachuSheet);
-	UnloadTexture(makuhitaSheet);
-	UnloadTexture(chikoritaSheet);
-	UnloadTexture(ContactImpulserLeft);
-	UnloadTexture(ContactImpulserRight);
-	UnloadTexture(ballSave);
-
-	for (int z = 1;z < 14;z++) UnloadTexture(frames_Latios[z]);
-	for (int z = 0;z < 2;z++) UnloadTexture(frames_Win[z]);
-	for (int z = 0;z < 8;z++) UnloadTexture(frames[z]);
-	for (int z = 0; z < 2; z++) UnloadTexture(frames_chinchou_idle[z]);
-	for (int z = 0; z < 2; z++) UnloadTexture(frames_chinchou_hit[z]);
-	for (int z = 0; z < 2; z++) UnloadTexture(frames_makuhita_idle[z]);
-	for (int z = 0; z < 2; z++) UnloadTexture(frames_chikorita_idle[z]);
-
-	StopMusicStream(music);
-	UnloadMusicStream(music);
-
-	delete ball;
+	// Headless runs never loaded them, and have no GPU to unload them from
+	if (!App->headless)
+	{
+		UnloadTexture(emptyBoard);
+		UnloadTexture(ballTex);
+		UnloadTexture(ContactImpulserLeft);
+		UnloadTexture(ContactImpulserRight);
+		UnloadTexture(ballSave);
+
+		// Animation frames are owned by ModuleAssets
+
+		for (int z = 0;z < 2;z++) UnloadTexture(frames_Win[z]);
+	}
+
+	for (BallState& ball : balls) App->physics->DestroyBody(ball.body);
+	balls.clear();
+
 	delete rubyBoard;
 	delete spoink;
 	delete pikachu;
@@ -1461,5 +1170,7 @@ bool ModuleGame::CleanUp()
 	delete rFlip;
 	delete lFlip;
 
+	table.Unload();
+
 	return true;
 }
\ No newline at end of file
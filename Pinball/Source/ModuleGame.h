@@ -2,6 +2,9 @@
 
 #include "Globals.h"
 #include "Module.h"
+#include "ModuleRender.h"
+#include "Animations.h"
+#include "Table.h"
 
 #include "p2Point.h"
 
@@ -11,16 +14,12 @@
 class PhysBody;
 class PhysicEntity;
 class Board;
-class Ball;
-class Obstacle;
 class Spring;
 class Pikachu;
 class Chinchou;
 class Makuhita;
 class Chikorita;
 
-class Block;
-
 class PalancaDer;
 class PalancaIzq;
 
@@ -44,6 +43,9 @@ class LeftFlipper;
 #define Chinchou2Bumper 13
 #define Chinchou3Bumper 14
 
+#define MULTIBALL_COLUMNS 8	// Extra balls are served in rows this wide, centred on the multiball spawn
+#define MULTIBALL_SPACING 24	// Pixels between served balls, a bit more than their diameter
+
 class ModuleGame : public Module
 {
 public:
@@ -51,108 +53,103 @@ public:
 	~ModuleGame();
 
 	bool Start();
+	update_status PreUpdate();
 	update_status Update();
 	bool CleanUp();
 	void OnCollision(PhysBody* bodyA, PhysBody* bodyB, int dir);
 
 	enum State{INGAME, DEAD, SCORE, WIN};
+
+private:
+	bool LoadTable(const char* path);
+	bool LoadAssets();
+	void CreateEntities();
+
+	void ServeBalls();
+	void AddBall(int x, int y);
+	void RemoveDrainedBalls();
+	int FindBall(const PhysBody* body) const;
+
 public:
 
 	std::vector<PhysicEntity*> entities;
-	Music music;
-	Sound gameOverMusic;
-	Sound extraLifeSound;
-	Sound winMusic;
-	Sound pointsSFX;
-	Sound deadSFX;
-	Sound impulserSFX;
+	int gameOverMusic;
+	int extraLifeSound;
+	int winMusic;
+	int pointsSFX;
+	int deadSFX;
+	int impulserSFX;
 
 	int flipperFX;
 	int spoink_chargeSFX;
 	int spoink_releaseSFX;
 	int chinchou_hitSFX;
 
-	int currentFrame = 0;
-	float frameTime = 0.15f;   // Frame time in seconds
-	float timer = 0.0f;
-	Texture2D frames[8];
-
-	int currentFrame_pikachu = 0;
-	float frameTime_pikachu = 0.15f;   // Frame time in seconds
-	float timer_pikachu = 0.0f;
-	Texture2D frames_pikachu[2];
-
-	Texture2D frames_Win[2];
+	// Creature animations, the clips are defined in Assets/Ruby/animations.txt
+	Animations animations;
+	int spoinkIdleClip = -1;
+	int spoinkChargeClip = -1;
+	int chinchouHitClip = -1;
+	uint pikachuAnimation = 0;
+	uint latiosAnimation = 0;
+
+	Texture2D frames_Win[2] = {};
+
+	// Every ball on the table, contiguous so the rules and the drawing go through them in one pass
+	struct BallState
+	{
+		PhysBody* body;
+		bool drained;	// Went through the drain, removed once the rules have run
+		uint64 served;	// Game tick it was put in play
+	};
+	std::vector<BallState> balls;
+	uint32 impulseBall = 0;	// Handle of the ball on the Pikachu kickback, resolves to NULL once it is gone
+
+	// Totals of the game being played, the table simulator reads them at game over
+	uint64 gameTicks = 0;
+	uint drainedBalls = 0;
+	uint64 ballLifeTicks = 0;
 
-	int currentFrames_latios = 1;
-	float framesTime_latios = 0.08f;   // Frame time in seconds
-	float timer_latios = 0.0f;
-	Texture2D frames_Latios[14];
-	bool backwards;
-
-	int currentFrame_chinchou = 0;
-	float frameTime_chinchou = 0.15f;   // Frame time in seconds
-	float timer_chinchou = 0.0f;
-	Texture2D frames_chinchou_idle[2];
-	Texture2D frames_chinchou_hit[2];
-
-	int currentFrame_makuhita = 0;
-	float frameTime_makuhita = 0.30f;   // Frame time in seconds
-	float timer_makuhita = 0.0f;
-	Texture2D frames_makuhita_idle[2];
-
-	int currentFrame_chikorita = 0;
-	float frameTime_chikorita = 0.35f;   // Frame time in seconds
-	float timer_chikorita = 0.0f;
-	Texture2D frames_chikorita_idle[2];
-
-	PhysBody* sensor;
-	PhysBody* sensorBlock;
-
-	Ball* ball;
 	int ballRad = 15;
 	Vector2 springForce = { 0.0f, -10.0f };
-	bool sensed;
+	bool sensed = false;
 	bool canImpulse = false;
 
-	bool basicImpulser;
+	bool basicImpulser = false;
 
 	float spoinkPos;
 
-	Board* rubyBoard;
-	Obstacle* rubyObstacle;
-
-	Texture2D emptyBoard;
-	Texture2D ballTex;
-	Texture2D palancaderSheet;
-	Texture2D palancaizqSheet;
-	Texture2D gameOver;
-	Texture2D ballSave;
+	Board* rubyBoard = NULL;
 
-	Texture2D ContactImpulserLeft;
-	Texture2D ContactImpulserRight;
+	Texture2D emptyBoard = {};
+	Texture2D ballTex = {};
+	Texture2D palancaderSheet = {};
+	Texture2D palancaizqSheet = {};
+	Texture2D gameOver = {};
+	Texture2D ballSave = {};
 
-	Spring* spoink;
-	Texture2D spoinkSheet;
-	Pikachu* pikachu;
-	RightFlipper* rFlip;
-	LeftFlipper* lFlip;
+	Texture2D ContactImpulserLeft = {};
+	Texture2D ContactImpulserRight = {};
 
-	Chinchou* chinchou1;
-	Chinchou* chinchou2;
-	Chinchou* chinchou3;
+	Spring* spoink = NULL;
+	Pikachu* pikachu = NULL;
+	RightFlipper* rFlip = NULL;
+	LeftFlipper* lFlip = NULL;
 
-	Makuhita* makuhita;
-	Chikorita* chikorita;
+	Chinchou* chinchou1 = NULL;
+	Chinchou* chinchou2 = NULL;
+	Chinchou* chinchou3 = NULL;
 
-	Block* blocker;
+	Makuhita* makuhita = NULL;
+	Chikorita* chikorita = NULL;
 
-	Texture2D pikachuSheet;
-	Texture2D chinchouSheet;
-	Texture2D makuhitaSheet;
-	Texture2D chikoritaSheet;
+	// Geometry and spawn points, mapped from the file given with -table
+	Table table;
 
 	Vector2 initBallPos = { 243 * 2, 250 * 2 };
+	vec2<int> multiballPos;
+	vec2<int> pikachuRight;
+	vec2<int> pikachuLeft;
 
 	bool bumper_hit = false;
 
@@ -171,15 +168,14 @@ public:
 	Font font;
 	char cadena[100];
 
-	bool start;
-	bool oneTime;
-	bool changeAnimation;
+	bool start = false;
+	bool oneTime = false;
 
-	bool contactRight;
-	bool contactLeft;
+	bool contactRight = false;
+	bool contactLeft = false;
 
 	bool extralife = false;
-	int textCounter;
+	int textCounter = 0;
 
 	vec2<int> ray;
 	bool ray_on;
@@ -0,0 +1,404 @@
+#include "Globals.h"
+#include "Application.h"
+#include "ModuleInput.h"
+#include "ModulePhysics.h"
+#include "MappedFile.h"
+
+#include "raylib.h"
+
+#include <string.h>
+#include <algorithm>
+
+// Keys the game reads, everything else is reported as released
+static const int input_keys[MAX_INPUT_KEYS] = { KEY_LEFT, KEY_RIGHT, KEY_DOWN, KEY_SPACE, KEY_F1 };
+static const char* key_names[MAX_INPUT_KEYS] = { "LEFT", "RIGHT", "DOWN", "SPACE", "F1" };
+
+static_assert(MAX_INPUT_KEYS <= REPLAY_STEPS_SHIFT, "Replay ticks have no room for more keys");
+static_assert(PHYSICS_MAX_STEPS < (1 << (8 - REPLAY_STEPS_SHIFT)), "Replay ticks have no room for more physics steps");
+
+// Replay file: header, then runs of identical ticks as (tick, count) byte pairs
+#define REPLAY_MAGIC 0x50524250 // "PBRP"
+#define REPLAY_VERSION 2
+
+struct ReplayHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint32 ticks;
+	uint32 state_hash;
+	uint32 ball_count;		// -balls and -physics-threads of the recording, the replay runs with them too
+	uint32 physics_threads;
+	uint32 table_hash;		// Of the -table file, a replay on any other table is refused
+};
+
+// FNV-1a of the whole file, 0 if it cannot be read
+static uint32 HashFile(const char* path)
+{
+	MappedFile file;
+	if (file.Open(path) == false) return 0;
+
+	uint32 hash = 2166136261u;
+	const uchar* bytes = (const uchar*)file.GetData();
+	for (size_t i = 0; i < file.GetSize(); ++i)
+	{
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+ModuleInput::ModuleInput(Application* app, bool start_enabled) : Module(app, start_enabled)
+{
+	scripted = false;
+	driven = false;
+	script_cursor = 0;
+	script_loop = 0;
+	frame = 0;
+
+	recording = false;
+	replaying = false;
+	replay_cursor = 0;
+	replay_hash = 0;
+
+	for (int i = 0; i < MAX_INPUT_KEYS; ++i)
+	{
+		keys[i] = previous_keys[i] = driven_keys[i] = false;
+	}
+
+	mouse_position = { 0.0f, 0.0f };
+	for (int i = 0; i < MAX_MOUSE_BUTTONS; ++i)
+	{
+		mouse_buttons[i] = previous_mouse_buttons[i] = false;
+	}
+}
+
+// Destructor
+ModuleInput::~ModuleInput()
+{}
+
+// Called each loop iteration
+update_status ModuleInput::PreUpdate()
+{
+	for (int i = 0; i < MAX_INPUT_KEYS; ++i)
+	{
+		previous_keys[i] = keys[i];
+	}
+
+	if (replaying)
+	{
+		// Stop before a tick the replay has no input for
+		if (replay_cursor >= replay.size()) return UPDATE_STOP;
+
+		for (int i = 0; i < MAX_INPUT_KEYS; ++i)
+		{
+			keys[i] = (replay[replay_cursor] & (1 << i)) != 0;
+		}
+	}
+	else if (scripted)
+	{
+		ApplyScript();
+	}
+	else if (driven)
+	{
+		for (int i = 0; i < MAX_INPUT_KEYS; ++i)
+		{
+			keys[i] = driven_keys[i];
+		}
+	}
+	else
+	{
+		for (int i = 0; i < MAX_INPUT_KEYS; ++i)
+		{
+			keys[i] = ::IsKeyDown(input_keys[i]);
+		}
+	}
+
+	// Mouse drags are not part of replays, so the mouse is left out while recording or replaying
+	if (!App->headless && !recording && !replaying)
+	{
+		mouse_position = ::GetMousePosition();
+		for (int i = 0; i < MAX_MOUSE_BUTTONS; ++i)
+		{
+			previous_mouse_buttons[i] = mouse_buttons[i];
+			mouse_buttons[i] = ::IsMouseButtonDown(i);
+		}
+	}
+
+	frame++;
+
+	return UPDATE_CONTINUE;
+}
+
+// Called before quitting
+bool ModuleInput::CleanUp()
+{
+	script.clear();
+	replay.clear();
+	return true;
+}
+
+void ModuleInput::StartDriving()
+{
+	driven = true;
+}
+
+void ModuleInput::SetKey(int key, bool down)
+{
+	int index = GetKeyIndex(key);
+	if (index >= 0) driven_keys[index] = down;
+}
+
+void ModuleInput::StartRecording()
+{
+	recording = true;
+	replay.clear();
+}
+
+bool ModuleInput::SaveReplay(const char* path, uint32 state_hash) const
+{
+	FILE* file = NULL;
+
+	if (fopen_s(&file, path, "wb") != 0 || file == NULL)
+	{
+		LOG("Cannot write replay: %s", path);
+		return false;
+	}
+
+	ReplayHeader header = { REPLAY_MAGIC, REPLAY_VERSION, (uint32)replay.size(), state_hash, App->ball_count, App->physics_threads, HashFile(App->table_file) };
+	fwrite(&header, sizeof(header), 1, file);
+
+	for (uint i = 0; i < replay.size();)
+	{
+		uchar run[2] = { replay[i], 0 };
+		while (i < replay.size() && replay[i] == run[0] && run[1] < 255)
+		{
+			run[1]++;
+			i++;
+		}
+		fwrite(run, sizeof(run), 1, file);
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool ModuleInput::LoadReplay(const char* path)
+{
+	FILE* file = NULL;
+
+	if (fopen_s(&file, path, "rb") != 0 || file == NULL)
+	{
+		LOG("Cannot open replay: %s", path);
+		return false;
+	}
+
+	ReplayHeader header = {};
+	bool ret = fread(&header, sizeof(header), 1, file) == 1 && header.magic == REPLAY_MAGIC && header.version == REPLAY_VERSION;
+
+	if (header.magic == REPLAY_MAGIC && header.version != REPLAY_VERSION)
+	{
+		printf("Replay %s is version %u, this build plays version %u\n", path, header.version, REPLAY_VERSION);
+	}
+
+	replay.clear();
+	replay.reserve(ret ? header.ticks : 0);
+
+	uchar run[2];
+	while (ret && replay.size() < header.ticks && fread(run, sizeof(run), 1, file) == 1)
+	{
+		replay.insert(replay.end(), run[1], run[0]);
+	}
+
+	fclose(file);
+
+	if (!ret || replay.size() != header.ticks)
+	{
+		LOG("Bad replay file: %s", path);
+		replay.clear();
+		return false;
+	}
+
+	if (header.table_hash != HashFile(App->table_file))
+	{
+		printf("Replay %s was recorded on another table than %s, pass the one it was recorded on with -table\n", path, App->table_file);
+		replay.clear();
+		return false;
+	}
+
+	// Called before the modules start, so the game is set up like the recording
+	if (header.ball_count != App->ball_count || header.physics_threads != App->physics_threads)
+	{
+		printf("Replaying with -balls %u -physics-threads %u, as recorded\n", header.ball_count, header.physics_threads);
+		App->ball_count = header.ball_count;
+		App->physics_threads = header.physics_threads;
+	}
+
+	replaying = true;
+	replay_cursor = 0;
+	replay_hash = header.state_hash;
+
+	return true;
+}
+
+int ModuleInput::GetReplaySteps() const
+{
+	if (!replaying || replay_cursor >= replay.size()) return -1;
+
+	return replay[replay_cursor] >> REPLAY_STEPS_SHIFT;
+}
+
+void ModuleInput::TickDone(int steps)
+{
+	if (recording)
+	{
+		replay.push_back(GetKeyMask() | (uchar)(steps << REPLAY_STEPS_SHIFT));
+	}
+	else if (replaying && replay_cursor < replay.size())
+	{
+		replay_cursor++;
+	}
+}
+
+bool ModuleInput::IsReplaying() const
+{
+	return replaying;
+}
+
+bool ModuleInput::ReplayFinished() const
+{
+	return replaying && replay_cursor >= replay.size();
+}
+
+uint ModuleInput::GetReplayTicks() const
+{
+	return replaying ? replay_cursor : (uint)replay.size();
+}
+
+uint32 ModuleInput::GetReplayHash() const
+{
+	return replay_hash;
+}
+
+// Script lines are "<frame> <key> <down|up>" or "loop <frames>", # starts a comment
+bool ModuleInput::LoadScript(const char* path, uint64 start_frame)
+{
+	FILE* file = NULL;
+
+	if (fopen_s(&file, path, "r") != 0 || file == NULL)
+	{
+		LOG("Cannot open input script: %s", path);
+		return false;
+	}
+
+	char line[128];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		char first[32];
+		char key_name[32];
+		char action[32];
+
+		const char* cursor = line;
+		int read = 0;
+		read += ReadToken(cursor, first, sizeof(first));
+		read += ReadToken(cursor, key_name, sizeof(key_name));
+		read += ReadToken(cursor, action, sizeof(action));
+
+		if (read == 0 || first[0] == '#') continue;
+
+		if (strcmp(first, "loop") == 0 && read >= 2)
+		{
+			script_loop = strtoull(key_name, NULL, 10);
+			continue;
+		}
+
+		InputEvent event = { strtoull(first, NULL, 10), -1, strcmp(action, "down") == 0 };
+		for (int i = 0; i < MAX_INPUT_KEYS; ++i)
+		{
+			if (strcmp(key_name, key_names[i]) == 0) event.key = input_keys[i];
+		}
+
+		if (read < 3 || event.key == -1)
+		{
+			LOG("Ignoring bad input script line: %s", line);
+			continue;
+		}
+
+		script.push_back(event);
+	}
+
+	fclose(file);
+
+	std::stable_sort(script.begin(), script.end(), [](const InputEvent& a, const InputEvent& b) { return a.frame < b.frame; });
+	scripted = true;
+	frame = start_frame;
+
+	return true;
+}
+
+bool ModuleInput::IsKeyDown(int key) const
+{
+	int i = GetKeyIndex(key);
+	return i != -1 && keys[i];
+}
+
+bool ModuleInput::IsKeyPressed(int key) const
+{
+	int i = GetKeyIndex(key);
+	return i != -1 && keys[i] && !previous_keys[i];
+}
+
+bool ModuleInput::IsKeyReleased(int key) const
+{
+	int i = GetKeyIndex(key);
+	return i != -1 && !keys[i] && previous_keys[i];
+}
+
+Vector2 ModuleInput::GetMousePosition() const
+{
+	return mouse_position;
+}
+
+bool ModuleInput::IsMouseButtonDown(int button) const
+{
+	return button >= 0 && button < MAX_MOUSE_BUTTONS && mouse_buttons[button];
+}
+
+bool ModuleInput::IsMouseButtonReleased(int button) const
+{
+	return button >= 0 && button < MAX_MOUSE_BUTTONS && !mouse_buttons[button] && previous_mouse_buttons[button];
+}
+
+uchar ModuleInput::GetKeyMask() const
+{
+	uchar mask = 0;
+	for (int i = 0; i < MAX_INPUT_KEYS; ++i)
+	{
+		if (keys[i]) mask |= (1 << i);
+	}
+
+	return mask;
+}
+
+int ModuleInput::GetKeyIndex(int key) const
+{
+	for (int i = 0; i < MAX_INPUT_KEYS; ++i)
+	{
+		if (input_keys[i] == key) return i;
+	}
+
+	return -1;
+}
+
+void ModuleInput::ApplyScript()
+{
+	uint64 script_frame = (script_loop > 0) ? frame % script_loop : frame;
+
+	// Restart the script when looping back to its first frame
+	if (script_frame == 0) script_cursor = 0;
+
+	while (script_cursor < script.size() && script[script_cursor].frame <= script_frame)
+	{
+		const InputEvent& event = script[script_cursor++];
+		keys[GetKeyIndex(event.key)] = event.down;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Module.h"
+#include "Globals.h"
+
+#include <vector>
+
+#define MAX_INPUT_KEYS 5
+#define MAX_MOUSE_BUTTONS 3
+
+// Replays store one byte per tick: pressed keys in the low bits, physics steps in the high ones
+#define REPLAY_STEPS_SHIFT 5
+
+// Key change read from an input script
+struct InputEvent
+{
+	uint64 frame;
+	int key;
+	bool down;
+};
+
+class ModuleInput : public Module
+{
+public:
+
+	ModuleInput(Application* app, bool start_enabled = true);
+	~ModuleInput();
+
+	update_status PreUpdate();
+	bool CleanUp();
+
+	// Replace the keyboard with a script file, see Assets/Scripts/attract_mode.txt for the format
+	// Looping scripts can start part way through, so batch runs of the same script do not all play alike
+	bool LoadScript(const char* path, uint64 start_frame = 0);
+
+	// Keys are only changed through SetKey(), the table simulator policies play this way
+	void StartDriving();
+	void SetKey(int key, bool down);
+
+	// Record every tick to a replay, or play one back instead of the keyboard
+	void StartRecording();
+	bool SaveReplay(const char* path, uint32 state_hash) const;
+	bool LoadReplay(const char* path);
+
+	// Physics steps recorded for the current tick, -1 when not replaying
+	int GetReplaySteps() const;
+	// Called once the physics steps of the tick are known
+	void TickDone(int steps);
+
+	bool IsReplaying() const;
+	bool ReplayFinished() const;
+	uint GetReplayTicks() const;
+	uint32 GetReplayHash() const;
+
+	// Same meaning as the raylib functions, but work without a window
+	bool IsKeyDown(int key) const;
+	bool IsKeyPressed(int key) const;
+	bool IsKeyReleased(int key) const;
+
+	// Mouse state latched in PreUpdate, so it can be read away from the main thread
+	Vector2 GetMousePosition() const;
+	bool IsMouseButtonDown(int button) const;
+	bool IsMouseButtonReleased(int button) const;
+
+private:
+
+	int GetKeyIndex(int key) const;
+	void ApplyScript();
+	uchar GetKeyMask() const;
+
+	bool keys[MAX_INPUT_KEYS];
+	bool previous_keys[MAX_INPUT_KEYS];
+
+	Vector2 mouse_position;
+	bool mouse_buttons[MAX_MOUSE_BUTTONS];
+	bool previous_mouse_buttons[MAX_MOUSE_BUTTONS];
+
+	bool scripted;
+	bool driven;
+	bool driven_keys[MAX_INPUT_KEYS];	// Taken as the keys of the next tick
+	std::vector<InputEvent> script;
+	uint script_cursor;
+	uint64 script_loop;
+	uint64 frame;
+
+	bool recording;
+	bool replaying;
+	std::vector<uchar> replay;
+	uint replay_cursor;
+	uint32 replay_hash;
+};
\ No newline at end of file
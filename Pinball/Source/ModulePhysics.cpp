@@ -3,16 +3,26 @@
 #include "ModuleRender.h"
 #include "ModulePhysics.h"
 #include "ModuleGame.h"
+#include "ModuleInput.h"
 
 #include "p2Point.h"
 
 #include <math.h>
+#include <algorithm>
 
 
 ModulePhysics::ModulePhysics(Application* app, bool start_enabled) : Module(app, start_enabled)
 {
 	world = NULL;
+	mouse_joint = NULL;
 	debug = false;
+	accumulator = 0.0f;
+
+	event_head = 0;
+	event_count = 0;
+	dropped_events = 0;
+	substeps = 0;
+	fixed_steps = 0;
 }
 
 // Destructor
@@ -25,34 +35,340 @@ bool ModulePhysics::Start()
 	LOG("Creating Physics 2D environment");
 	world = new b2World(b2Vec2(GRAVITY_X, -GRAVITY_Y));
 	world->SetContactListener(this);
+	world->SetWorkerCount((int32)App->physics_threads);
+
+	// Every piece of static table geometry goes on this body as a fixture, it also anchors the mouse joint
+	static_body = AllocateBody();
 
 	b2BodyDef bd;
+	bd.userData.pointer = static_body->handle;
+	static_body->body = world->CreateBody(&bd);
 
 	CreateScenarioGround();
-	ground = world->CreateBody(&bd);
 	
 	return true;
 }
 
 update_status ModulePhysics::PreUpdate()
 {
-	world->Step(1.0f / 60.0f, 6, 2);
+	int steps = App->input->GetReplaySteps();
+
+	if (steps >= 0)
+	{
+		// Replays repeat the recorded steps, so the world follows the same path bit for bit
+		for (int i = 0; i < steps; ++i) Step();
+
+		App->input->TickDone(steps);
+		InterpolateBodies(1.0f);
+
+		return UPDATE_CONTINUE;
+	}
+
+	// Consume the frame time in fixed steps, so the simulation runs at the same speed whatever the FPS
+	accumulator += App->dt;
+
+	steps = 0;
+	while (accumulator >= PHYSICS_TIMESTEP && steps < PHYSICS_MAX_STEPS)
+	{
+		Step();
+
+		accumulator -= PHYSICS_TIMESTEP;
+		steps++;
+	}
+
+	// Too slow to keep up: drop the time left instead of carrying it to the next frames
+	if (accumulator >= PHYSICS_TIMESTEP) accumulator = fmodf(accumulator, PHYSICS_TIMESTEP);
+
+	App->input->TickDone(steps);
+	InterpolateBodies(accumulator / PHYSICS_TIMESTEP);
+
+	return UPDATE_CONTINUE;
+}
+
+// Fast steps are split so a ball never moves far enough to skip a wall, quiet ones stay a single world step
+void ModulePhysics::Step()
+{
+	StoreInterpolationStates();
+
+	int count = GetSubsteps();
+	for (int i = 0; i < count; ++i) world->Step(PHYSICS_TIMESTEP / count, PHYSICS_VELOCITY_ITERATIONS, PHYSICS_POSITION_ITERATIONS);
+
+	substeps += count;
+	fixed_steps++;
+
+	DispatchCollisions();
+}
+
+// Finds the thinnest solid fixture in an area
+class ThinnestWallQuery : public b2QueryCallback
+{
+public:
+
+	ThinnestWallQuery(ModulePhysics* physics, b2Body* ball, float thinnest) : physics(physics), ball(ball), thinnest(thinnest) {}
+
+	bool ReportFixture(b2Fixture* fixture) override
+	{
+		if (fixture->GetBody() != ball && !fixture->IsSensor()) thinnest = MIN(thinnest, physics->GetThickness(fixture));
+		return true;
+	}
+
+	ModulePhysics* physics;
+	b2Body* ball;
+	float thinnest;
+};
+
+int ModulePhysics::GetSubsteps()
+{
+	int count = 1;
+
+	for (PhysBody* ball : balls)
+	{
+		float radius = ball->body->GetFixtureList()->GetShape()->m_radius;
+		float travel = ball->body->GetLinearVelocity().Length() * PHYSICS_TIMESTEP;
+
+		// Moving less than its radius a ball always ends a step overlapping whatever it hits
+		if (travel < radius) continue;
+
+		b2Vec2 position = ball->body->GetPosition();
+		b2AABB area;
+		area.lowerBound = position - b2Vec2(travel + radius, travel + radius);
+		area.upperBound = position + b2Vec2(travel + radius, travel + radius);
+
+		ThinnestWallQuery query(this, ball->body, 2.0f * radius);
+		world->QueryAABB(&query, area);
+
+		float safe_travel = PHYSICS_SUBSTEP_TRAVEL * (2.0f * radius + query.thinnest);
+		count = MAX(count, MIN((int)ceilf(travel / safe_travel), PHYSICS_MAX_SUBSTEPS));
+	}
+
+	return count;
+}
+
+// Twice the area over the perimeter of a closed polygon: the width of a thin strip
+static float GetLoopThickness(const b2Vec2* vertices, int count)
+{
+	float area = 0.0f, perimeter = 0.0f;
+	for (int i = 0; i < count; ++i)
+	{
+		const b2Vec2& a = vertices[i];
+		const b2Vec2& b = vertices[(i + 1) % count];
+		area += a.x * b.y - b.x * a.y;
+		perimeter += (b - a).Length();
+	}
+
+	return (perimeter > 0.0f) ? fabsf(area) / perimeter : 0.0f;
+}
+
+// Worked out when the fixture is made and kept in its user data, the sub-step query reads it every step
+static float GetShapeThickness(const b2Shape& shape)
+{
+	if (shape.GetType() == b2Shape::e_circle) return shape.m_radius;
+
+	if (shape.GetType() == b2Shape::e_polygon)
+	{
+		const b2PolygonShape& polygon = (const b2PolygonShape&)shape;
+		return MAX(polygon.m_radius, GetLoopThickness(polygon.m_vertices, polygon.m_count));
+	}
+
+	// Chains are edges, only their skin is solid
+	return shape.m_radius;
+}
+
+float ModulePhysics::GetThickness(b2Fixture* fixture)
+{
+	return fixture->GetUserData().thickness;
+}
+
+// FNV-1a over the transform and velocity of every body, equal hashes mean the same simulation
+uint32 ModulePhysics::GetStateHash() const
+{
+	uint32 hash = 2166136261u;
 
-	for (b2Contact* c = world->GetContactList(); c; c = c->GetNext())
+	for (const b2Body* b = world->GetBodyList(); b; b = b->GetNext())
 	{
-		if (c->GetFixtureA()->IsSensor() && c->IsTouching())
+		float state[6] = { b->GetPosition().x, b->GetPosition().y, b->GetAngle(), b->GetLinearVelocity().x, b->GetLinearVelocity().y, b->GetAngularVelocity() };
+
+		const uchar* bytes = (const uchar*)state;
+		for (uint i = 0; i < sizeof(state); ++i)
 		{
-			b2BodyUserData data1 = c->GetFixtureA()->GetBody()->GetUserData();
-			b2BodyUserData data2 = c->GetFixtureA()->GetBody()->GetUserData();
+			hash = (hash ^ bytes[i]) * 16777619u;
+		}
+	}
+
+	return hash;
+}
+
+// Sensors only report the edges: entering when the first fixture touches, leaving when the last one stops
+void ModulePhysics::UpdateOverlap(b2Contact* contact, bool touching)
+{
+	b2Fixture* sensor_fixture = contact->GetFixtureA()->IsSensor() ? contact->GetFixtureA() : contact->GetFixtureB();
+	b2Fixture* other_fixture = (sensor_fixture == contact->GetFixtureA()) ? contact->GetFixtureB() : contact->GetFixtureA();
+
+	PhysBody* sensor = GetBody(sensor_fixture->GetBody());
+	PhysBody* other = GetBody(other_fixture->GetBody());
+	if (sensor == NULL || other == NULL) return;
+
+	// Sensors made by the game have no listener, the body that went in tells its own
+	Module* listener = (sensor->listener != NULL) ? sensor->listener : other->listener;
+	int interaction = GetInteraction(sensor_fixture);
+	bool notify = (listener != NULL && interaction >= 2);
+
+	// The static body holds many sensors, the pair is told apart by the sensor fixture
+	uint index = 0;
+	while (index < overlaps.size() && (overlaps[index].fixture != sensor_fixture || overlaps[index].other != other->handle)) index++;
 
-			PhysBody* pb1 = (PhysBody*)data1.pointer;
-			PhysBody* pb2 = (PhysBody*)data2.pointer;
-			if (pb1 && pb2 && pb1->listener)
-				pb1->listener->OnCollision(pb1, pb2, pb1->id);
+	if (touching)
+	{
+		if (index < overlaps.size())
+		{
+			overlaps[index].contacts++;
+			return;
 		}
+
+		overlaps.push_back(SensorOverlap{ sensor->handle, sensor_fixture, other->handle, 1 });
+		if (notify) QueueCollision(SENSOR_ENTER, listener, sensor, other, interaction);
 	}
+	else if (index < overlaps.size() && --overlaps[index].contacts == 0)
+	{
+		overlaps[index] = overlaps.back();
+		overlaps.pop_back();
+		if (notify) QueueCollision(SENSOR_EXIT, listener, sensor, other, interaction);
+	}
+}
 
-	return UPDATE_CONTINUE;
+uint ModulePhysics::GetOverlapCount(const PhysBody* sensor) const
+{
+	uint count = 0;
+	for (const SensorOverlap& overlap : overlaps)
+	{
+		if (overlap.sensor == sensor->handle) count++;
+	}
+
+	return count;
+}
+
+// A pair touching through several fixtures (chain edges) in the same step is reported once
+void ModulePhysics::QueueCollision(CollisionEventType type, Module* listener, PhysBody* body, PhysBody* other, int dir)
+{
+	for (uint i = 0; i < event_count; ++i)
+	{
+		const CollisionEvent& event = events[(event_head + i) % PHYSICS_MAX_EVENTS];
+		if (event.type == type && event.listener == listener && event.body == body->handle && event.other == other->handle && event.dir == dir) return;
+	}
+
+	if (event_count == PHYSICS_MAX_EVENTS)
+	{
+		dropped_events++;
+		return;
+	}
+
+	events[(event_head + event_count) % PHYSICS_MAX_EVENTS] = CollisionEvent{ type, listener, body->handle, other->handle, dir };
+	event_count++;
+}
+
+// Runs after the step, so listeners can play sounds and apply impulses on a world that is not being solved
+void ModulePhysics::DispatchCollisions()
+{
+	while (event_count > 0)
+	{
+		CollisionEvent event = events[event_head];
+		event_head = (event_head + 1) % PHYSICS_MAX_EVENTS;
+		event_count--;
+
+		// Skipped if one of the bodies was destroyed since the event was queued
+		PhysBody* body = GetBody(event.body);
+		PhysBody* other = GetBody(event.other);
+		if (body == NULL || other == NULL) continue;
+
+		if (event.type == SENSOR_EXIT) event.listener->OnSensorExit(body, other, event.dir);
+		else event.listener->OnCollision(body, other, event.dir);
+	}
+}
+
+PhysBody* ModulePhysics::AllocateBody()
+{
+	uint index;
+
+	if (!free_bodies.empty())
+	{
+		index = free_bodies.back();
+		free_bodies.pop_back();
+		body_pool[index] = PhysBody();
+	}
+	else
+	{
+		index = (uint)body_pool.size();
+		body_pool.emplace_back();
+		body_generations.push_back(1);
+	}
+
+	body_pool[index].handle = (body_generations[index] << BODY_HANDLE_INDEX_BITS) | index;
+	return &body_pool[index];
+}
+
+void ModulePhysics::DestroyBody(PhysBody* pbody)
+{
+	if (pbody == NULL || pbody->body == NULL) return;
+
+	// Sensors it was touching report the exit from here
+	world->DestroyBody(pbody->body);
+	pbody->body = NULL;
+
+	interpolated_bodies.erase(std::remove(interpolated_bodies.begin(), interpolated_bodies.end(), pbody), interpolated_bodies.end());
+	balls.erase(std::remove(balls.begin(), balls.end(), pbody), balls.end());
+
+	// Handles to the old body, queued events included, stop resolving
+	uint index = pbody->handle & BODY_HANDLE_INDEX_MASK;
+	body_generations[index] = (body_generations[index] & BODY_HANDLE_GENERATION_MASK) + 1;
+	if (body_generations[index] > BODY_HANDLE_GENERATION_MASK) body_generations[index] = 1;
+
+	free_bodies.push_back(index);
+}
+
+PhysBody* ModulePhysics::GetBody(BodyHandle handle)
+{
+	uint index = handle & BODY_HANDLE_INDEX_MASK;
+	uint generation = handle >> BODY_HANDLE_INDEX_BITS;
+
+	if (index >= body_pool.size() || body_generations[index] != generation) return NULL;
+
+	return &body_pool[index];
+}
+
+PhysBody* ModulePhysics::GetBody(b2Body* body)
+{
+	return GetBody((BodyHandle)body->GetUserData().pointer);
+}
+
+uint ModulePhysics::GetBodyCount() const
+{
+	return (uint)(body_pool.size() - free_bodies.size());
+}
+
+void ModulePhysics::AddInterpolatedBody(PhysBody* pbody)
+{
+	pbody->interpolated = true;
+	pbody->ResetInterpolation();
+	interpolated_bodies.push_back(pbody);
+}
+
+void ModulePhysics::StoreInterpolationStates()
+{
+	for (PhysBody* pbody : interpolated_bodies)
+	{
+		pbody->previous_position = pbody->body->GetPosition();
+		pbody->previous_angle = pbody->body->GetAngle();
+	}
+}
+
+void ModulePhysics::InterpolateBodies(float alpha)
+{
+	for (PhysBody* pbody : interpolated_bodies)
+	{
+		b2Vec2 position = pbody->body->GetPosition();
+		pbody->render_position = (1.0f - alpha) * pbody->previous_position + alpha * position;
+		pbody->render_angle = (1.0f - alpha) * pbody->previous_angle + alpha * pbody->body->GetAngle();
+	}
 }
 
 update_status ModulePhysics::Update() {
@@ -61,14 +377,23 @@ update_status ModulePhysics::Update() {
 }
 
 
+PhysBody* ModulePhysics::CreateBall(int x, int y, int radius)
+{
+	PhysBody* pbody = CreateCircle(x, y, radius, b2_dynamicBody);
+	pbody->body->SetBullet(true);
+
+	balls.push_back(pbody);
+	return pbody;
+}
+
 PhysBody* ModulePhysics::CreateCircle(int x, int y, int radius, b2BodyType bType)
 {
-	PhysBody* pbody = new PhysBody();
+	PhysBody* pbody = AllocateBody();
 
 	b2BodyDef body;
 	body.type = bType;
 	body.position.Set(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y));
-	body.userData.pointer = reinterpret_cast<uintptr_t>(pbody);
+	body.userData.pointer = pbody->handle;
 
 	b2Body* b = world->CreateBody(&body);
 
@@ -77,6 +402,7 @@ PhysBody* ModulePhysics::CreateCircle(int x, int y, int radius, b2BodyType bType
 	b2FixtureDef fixture;
 	fixture.shape = &shape;
 	fixture.density = 1.0f;
+	fixture.userData.thickness = shape.m_radius;
 
 	b->CreateFixture(&fixture);
 
@@ -93,34 +419,28 @@ void ModulePhysics::CreateScenarioGround()
 	int y = SCREEN_HEIGHT / 1.5f;
 	int diameter = SCREEN_WIDTH / 2;
 
-	// Create a static body in the middle of the screen
-	b2BodyDef body;
-	body.type = b2_staticBody;
-	body.position.Set(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y));
-
-	// Add this static body to the World
-	b2Body* big_ball = world->CreateBody(&body);
-
 	// Create a big circle shape
 	b2CircleShape shape;
+	shape.m_p.Set(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y));
 	shape.m_radius = PIXEL_TO_METERS(diameter) * 0.5f;
 
 	// Create a fixture and associate the circle to it
 	b2FixtureDef fixture;
 	fixture.shape = &shape;
+	fixture.userData.thickness = shape.m_radius;
 
-	// Add the ficture (plus shape) to the static body
-	big_ball->CreateFixture(&fixture);
+	// Add the fixture (plus shape) to the static body
+	static_body->body->CreateFixture(&fixture);
 }
 
 PhysBody* ModulePhysics::CreateRectangle(int x, int y, int width, int height, b2BodyType bType, int inf)
 {
-	PhysBody* pbody = new PhysBody();
+	PhysBody* pbody = AllocateBody();
 
 	b2BodyDef body;
 	body.type = bType;
 	body.position.Set(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y));
-	body.userData.pointer = reinterpret_cast<uintptr_t>(pbody);
+	body.userData.pointer = pbody->handle;
 
 	b2Body* b = world->CreateBody(&body);
 	b2PolygonShape box;
@@ -129,6 +449,8 @@ PhysBody* ModulePhysics::CreateRectangle(int x, int y, int width, int height, b2
 	b2FixtureDef fixture;
 	fixture.shape = &box;
 	fixture.density = 1.0f;
+	fixture.userData.interaction = inf;
+	fixture.userData.thickness = GetShapeThickness(*fixture.shape);
 
 	b->CreateFixture(&fixture);
 
@@ -142,12 +464,12 @@ PhysBody* ModulePhysics::CreateRectangle(int x, int y, int width, int height, b2
 
 PhysBody* ModulePhysics::CreateRectangleSensor(int x, int y, int width, int height, b2BodyType bType, int inf)
 {
-	PhysBody* pbody = new PhysBody();
+	PhysBody* pbody = AllocateBody();
 
 	b2BodyDef body;
 	body.type = bType;
 	body.position.Set(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y));
-	body.userData.pointer = reinterpret_cast<uintptr_t>(pbody);
+	body.userData.pointer = pbody->handle;
 
 	b2Body* b = world->CreateBody(&body);
 
@@ -158,6 +480,8 @@ PhysBody* ModulePhysics::CreateRectangleSensor(int x, int y, int width, int heig
 	fixture.shape = &box;
 	fixture.density = 1.0f;
 	fixture.isSensor = true;
+	fixture.userData.interaction = inf;
+	fixture.userData.thickness = GetShapeThickness(*fixture.shape);
 
 	b->CreateFixture(&fixture);
 
@@ -169,73 +493,69 @@ PhysBody* ModulePhysics::CreateRectangleSensor(int x, int y, int width, int heig
 	return pbody;
 }
 
-PhysBody* ModulePhysics::CreateBumper(int x, int y, int radius, b2BodyType bType, int inf)
+b2World* ModulePhysics::GetWorld() const
 {
-	PhysBody* pbody = new PhysBody();
-
-	b2BodyDef body;
-	body.type = bType;
-	body.position.Set(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y));
-	body.userData.pointer = reinterpret_cast<uintptr_t>(pbody);
+	return world;
+}
 
-	b2Body* b = world->CreateBody(&body);
+PhysBody* ModulePhysics::GetStaticBody() const
+{
+	return static_body;
+}
 
-	b2PolygonShape box;
+b2Fixture* ModulePhysics::AddStaticChain(const b2Vec2* vertices, int count, int inf, bool solid)
+{
+	b2ChainShape shape;
+	shape.CreateLoop(vertices, count);
 
-	b2CircleShape shape;
-	shape.m_radius = PIXEL_TO_METERS(radius);
 	b2FixtureDef fixture;
 	fixture.shape = &shape;
-	fixture.density = 1.0f;
-	fixture.restitution = 1.5f;
-
-	b->CreateFixture(&fixture);
-	pbody->width = pbody->height = radius;
+	fixture.userData.interaction = inf;
+	fixture.userData.thickness = solid ? MAX(shape.m_radius, GetLoopThickness(vertices, count)) : GetShapeThickness(shape);
 
-	pbody->id = inf;
-	pbody->body = b;
-
-	return pbody;
+	return static_body->body->CreateFixture(&fixture);
 }
 
-PhysBody* ModulePhysics::CreateChain(int x, int y, const int* points, int size, b2BodyType bType, int inf)
+b2Fixture* ModulePhysics::AddStaticSensor(int x, int y, int width, int height, int inf)
 {
-	PhysBody* pbody = new PhysBody();
-
-	b2BodyDef body;
-	body.type = bType;
-	body.position.Set(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y));
-	body.userData.pointer = reinterpret_cast<uintptr_t>(pbody);
-	
-	b2Body* b = world->CreateBody(&body);
+	b2PolygonShape box;
+	box.SetAsBox(PIXEL_TO_METERS(width) * 0.5f, PIXEL_TO_METERS(height) * 0.5f, b2Vec2(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y)), 0.0f);
 
-	b2ChainShape shape;
-	b2Vec2* p = new b2Vec2[size / 2];
+	b2FixtureDef fixture;
+	fixture.shape = &box;
+	fixture.isSensor = true;
+	fixture.userData.interaction = inf;
+	fixture.userData.thickness = GetShapeThickness(*fixture.shape);
 
-	for (int i = 0; i < size; ++i)
-	{
-		TraceLog(LOG_INFO, "%i", (points[i]));
-	}
-	for (int i = 0; i < size / 2; ++i)
-	{
-		p[i].x = PIXEL_TO_METERS(points[i * 2 + 0]);
-		p[i].y = PIXEL_TO_METERS(points[i * 2 + 1]);
-	}
+	return static_body->body->CreateFixture(&fixture);
+}
 
-	shape.CreateLoop(p, size / 2);
+b2Fixture* ModulePhysics::AddStaticBumper(int x, int y, int radius, int inf)
+{
+	b2CircleShape shape;
+	shape.m_p.Set(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y));
+	shape.m_radius = PIXEL_TO_METERS(radius);
 
 	b2FixtureDef fixture;
 	fixture.shape = &shape;
+	fixture.restitution = App->tuning.bumper_restitution;
+	fixture.userData.interaction = inf;
+	fixture.userData.thickness = GetShapeThickness(*fixture.shape);
 
-	b->CreateFixture(&fixture);
-
-	delete p;
+	return static_body->body->CreateFixture(&fixture);
+}
 
-	pbody->body = b;
-	pbody->width = pbody->height = 0;
-	pbody->id = inf;
+// A static body cannot be disabled one fixture at a time, the filter stops it from touching anything instead
+void ModulePhysics::SetFixtureEnabled(b2Fixture* fixture, bool enabled)
+{
+	b2Filter filter = fixture->GetFilterData();
+	filter.maskBits = enabled ? 0xFFFF : 0;
+	fixture->SetFilterData(filter);
+}
 
-	return pbody;
+int ModulePhysics::GetInteraction(b2Fixture* fixture)
+{
+	return fixture->GetUserData().interaction;
 }
 
 b2RevoluteJoint* ModulePhysics::CreateFlipper(PhysBody* bodyA, PhysBody* bodyB, b2Vec2 anchor) {
@@ -245,7 +565,7 @@ b2RevoluteJoint* ModulePhysics::CreateFlipper(PhysBody* bodyA, PhysBody* bodyB,
 	def.collideConnected = false;
 	def.enableLimit = true;
 	def.enableMotor = true;
-	def.maxMotorTorque = 150.0f;
+	def.maxMotorTorque = App->tuning.flipper_torque;
 	
 	if (anchor.x > PIXEL_TO_METERS(SCREEN_WIDTH/2)) { // Right flipper
 		def.upperAngle = 0.15f * b2_pi;
@@ -278,7 +598,7 @@ b2PrismaticJoint* ModulePhysics::CreateSpring(PhysBody* bodyA, PhysBody* bodyB,
 	def.enableLimit = true;
 	def.localAxisA.Set(axis.x, axis.y);
 	def.enableMotor = true;
-	def.maxMotorForce = 200.0f;
+	def.maxMotorForce = App->tuning.spring_force;
 
 	// Create & add to world
 	b2PrismaticJoint* prismaticJoint = (b2PrismaticJoint*)world->CreateJoint(&def);
@@ -288,22 +608,24 @@ b2PrismaticJoint* ModulePhysics::CreateSpring(PhysBody* bodyA, PhysBody* bodyB,
 
 update_status ModulePhysics::PostUpdate()
 {
-	if (IsKeyPressed(KEY_F1))
+	if (App->input->IsKeyPressed(KEY_F1))
 	{
 		debug = !debug;
 	}
 
-	if (!debug)
+	if (!debug || App->headless)
 	{
 		return UPDATE_CONTINUE;
 	}
 
 	b2Body* mouseSelect = nullptr;
-	Vector2 mousePosition = GetMousePosition();
+	Vector2 mousePosition = App->input->GetMousePosition();
 	b2Vec2 pMousePosition = b2Vec2(PIXEL_TO_METERS(mousePosition.x), PIXEL_TO_METERS(mousePosition.y));
 
-	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	b2Body* const* bodies = world->GetBodyArray();
+	for (int32 index = 0; index < world->GetBodyCount(); ++index)
 	{
+		b2Body* b = bodies[index];
 		for (b2Fixture* f = b->GetFixtureList(); f; f = f->GetNext())
 		{
 			switch (f->GetType())
@@ -312,9 +634,9 @@ update_status ModulePhysics::PostUpdate()
 			case b2Shape::e_circle:
 			{
 				b2CircleShape* shape = (b2CircleShape*)f->GetShape();
-				b2Vec2 pos = f->GetBody()->GetPosition();
+				b2Vec2 pos = f->GetBody()->GetWorldPoint(shape->m_p);
 
-				DrawCircleLines(METERS_TO_PIXELS(pos.x), METERS_TO_PIXELS(pos.y), (float)METERS_TO_PIXELS(shape->m_radius), Color{ 128, 128, 128, 255 });
+				App->renderer->DrawCircleLines(METERS_TO_PIXELS(pos.x), METERS_TO_PIXELS(pos.y), (float)METERS_TO_PIXELS(shape->m_radius), Color{ 128, 128, 128, 255 });
 			}
 			break;
 
@@ -329,13 +651,13 @@ update_status ModulePhysics::PostUpdate()
 				{
 					v = b->GetWorldPoint(polygonShape->m_vertices[i]);
 					if (i > 0)
-						DrawLine(METERS_TO_PIXELS(prev.x), METERS_TO_PIXELS(prev.y), METERS_TO_PIXELS(v.x), METERS_TO_PIXELS(v.y), RED);
+						App->renderer->DrawLine(METERS_TO_PIXELS(prev.x), METERS_TO_PIXELS(prev.y), METERS_TO_PIXELS(v.x), METERS_TO_PIXELS(v.y), RED);
 
 					prev = v;
 				}
 
 				v = b->GetWorldPoint(polygonShape->m_vertices[0]);
-				DrawLine(METERS_TO_PIXELS(prev.x), METERS_TO_PIXELS(prev.y), METERS_TO_PIXELS(v.x), METERS_TO_PIXELS(v.y), RED);
+				App->renderer->DrawLine(METERS_TO_PIXELS(prev.x), METERS_TO_PIXELS(prev.y), METERS_TO_PIXELS(v.x), METERS_TO_PIXELS(v.y), RED);
 			}
 			break;
 
@@ -349,12 +671,12 @@ update_status ModulePhysics::PostUpdate()
 				{
 					v = b->GetWorldPoint(shape->m_vertices[i]);
 					if (i > 0)
-						DrawLine(METERS_TO_PIXELS(prev.x), METERS_TO_PIXELS(prev.y), METERS_TO_PIXELS(v.x), METERS_TO_PIXELS(v.y), GREEN);
+						App->renderer->DrawLine(METERS_TO_PIXELS(prev.x), METERS_TO_PIXELS(prev.y), METERS_TO_PIXELS(v.x), METERS_TO_PIXELS(v.y), GREEN);
 					prev = v;
 				}
 
 				v = b->GetWorldPoint(shape->m_vertices[0]);
-				DrawLine(METERS_TO_PIXELS(prev.x), METERS_TO_PIXELS(prev.y), METERS_TO_PIXELS(v.x), METERS_TO_PIXELS(v.y), GREEN);
+				App->renderer->DrawLine(METERS_TO_PIXELS(prev.x), METERS_TO_PIXELS(prev.y), METERS_TO_PIXELS(v.x), METERS_TO_PIXELS(v.y), GREEN);
 			}
 			break;
 
@@ -366,14 +688,15 @@ update_status ModulePhysics::PostUpdate()
 
 				v1 = b->GetWorldPoint(shape->m_vertex0);
 				v1 = b->GetWorldPoint(shape->m_vertex1);
-				DrawLine(METERS_TO_PIXELS(v1.x), METERS_TO_PIXELS(v1.y), METERS_TO_PIXELS(v2.x), METERS_TO_PIXELS(v2.y), BLUE);
+				App->renderer->DrawLine(METERS_TO_PIXELS(v1.x), METERS_TO_PIXELS(v1.y), METERS_TO_PIXELS(v2.x), METERS_TO_PIXELS(v2.y), BLUE);
 			}
 			break;
 			}
 
-			if (mouse_joint == nullptr && mouseSelect == nullptr && IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
+			if (mouse_joint == nullptr && mouseSelect == nullptr && App->input->IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
 
-				if (f->TestPoint(pMousePosition)) {
+				// The joint is anchored on the static body, it cannot grab itself
+				if (b != static_body->body && f->TestPoint(pMousePosition)) {
 					mouseSelect = b;
 				}
 			}
@@ -383,7 +706,7 @@ update_status ModulePhysics::PostUpdate()
 	if (mouseSelect) {
 		b2MouseJointDef def;
 
-		def.bodyA = ground;
+		def.bodyA = static_body->body;
 		def.bodyB = mouseSelect;
 		def.target = pMousePosition;
 		def.damping = 0.5f;
@@ -393,16 +716,16 @@ update_status ModulePhysics::PostUpdate()
 		mouse_joint = (b2MouseJoint*)world->CreateJoint(&def);
 	}
 
-	else if (mouse_joint && IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
+	else if (mouse_joint && App->input->IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
 		mouse_joint->SetTarget(pMousePosition);
 		b2Vec2 anchorPosition = mouse_joint->GetBodyB()->GetPosition();
 		anchorPosition.x = METERS_TO_PIXELS(anchorPosition.x);
 		anchorPosition.y = METERS_TO_PIXELS(anchorPosition.y);
 
-		DrawLine(anchorPosition.x, anchorPosition.y, mousePosition.x, mousePosition.y, RED);
+		App->renderer->DrawLine(anchorPosition.x, anchorPosition.y, mousePosition.x, mousePosition.y, RED);
 	}
 
-	else if (mouse_joint && IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
+	else if (mouse_joint && App->input->IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
 		world->DestroyJoint(mouse_joint);
 		mouse_joint = nullptr;
 	}
@@ -414,7 +737,24 @@ update_status ModulePhysics::PostUpdate()
 bool ModulePhysics::CleanUp()
 {
 	LOG("Destroying physics world");
+	if (dropped_events > 0) LOG("%u collision events dropped, PHYSICS_MAX_EVENTS is too small", dropped_events);
+	if (fixed_steps > 0) LOG("%.3f world steps per physics step", (float)substeps / fixed_steps);
+
+	b2AllocatorStats memory = world->GetAllocatorStats();
+	LOG("Box2D took %d chunks of 16k, used up to %d bytes per step, %d step allocations did not fit", memory.blockChunks, memory.stackPeak, memory.stackHeapAllocations);
+
 	// Delete the whole physics world!
+	delete world;
+	world = NULL;
+	static_body = NULL;
+
+	interpolated_bodies.clear();
+	balls.clear();
+	overlaps.clear();
+	body_pool.clear();
+	body_generations.clear();
+	free_bodies.clear();
+
 	return true;
 }
 
@@ -430,6 +770,30 @@ float PhysBody::GetRotation() const
 	return body->GetAngle();
 }
 
+void PhysBody::GetRenderPosition(int& x, int& y) const
+{
+	if (!interpolated)
+	{
+		GetPhysicPosition(x, y);
+		return;
+	}
+
+	x = METERS_TO_PIXELS(render_position.x);
+	y = METERS_TO_PIXELS(render_position.y);
+}
+
+float PhysBody::GetRenderRotation() const
+{
+	return interpolated ? render_angle : body->GetAngle();
+}
+
+// Call after teleporting a body, so it is not drawn sliding from its old position
+void PhysBody::ResetInterpolation()
+{
+	previous_position = render_position = body->GetPosition();
+	previous_angle = render_angle = body->GetAngle();
+}
+
 bool PhysBody::Contains(int x, int y) const
 {
 	b2Vec2 p(PIXEL_TO_METERS(x), PIXEL_TO_METERS(y));
@@ -480,19 +844,39 @@ int PhysBody::RayCast(int x1, int y1, int x2, int y2, float& normal_x, float& no
 
 void ModulePhysics::BeginContact(b2Contact* contact)
 {
-	b2BodyUserData dataA = contact->GetFixtureA()->GetBody()->GetUserData();
-	b2BodyUserData dataB = contact->GetFixtureB()->GetBody()->GetUserData();
-	
-	PhysBody* physA = (PhysBody*)dataA.pointer;
-	PhysBody* physB = (PhysBody*)dataB.pointer;
+	if (contact->GetFixtureA()->IsSensor() || contact->GetFixtureB()->IsSensor())
+	{
+		UpdateOverlap(contact, true);
+		return;
+	}
+
+	PhysBody* physA = GetBody(contact->GetFixtureA()->GetBody());
+	PhysBody* physB = GetBody(contact->GetFixtureB()->GetBody());
+	int interaction = GetInteraction(contact->GetFixtureA());
+
+	// Static fixtures are always B against a ball, the interaction can be on either side
+	if (interaction < 2)
+	{
+		interaction = GetInteraction(contact->GetFixtureB());
+		std::swap(physA, physB);
+	}
 
-	if(physA->id >= 2)
+	if(physA && interaction >= 2)
 	{ 
-		if (physA && physA->listener != NULL)
-			physA->listener->OnCollision(physA, physB, physA->id);
+		if (physA->listener != NULL)
+			QueueCollision(COLLISION_BEGIN, physA->listener, physA, physB, interaction);
 
 		if (physB && physB->listener != NULL)
-			physB->listener->OnCollision(physB, physA, physA->id);
+			QueueCollision(COLLISION_BEGIN, physB->listener, physB, physA, interaction);
 	}
 
+}
+
+// Also called when a body touching a sensor is destroyed
+void ModulePhysics::EndContact(b2Contact* contact)
+{
+	if (contact->GetFixtureA()->IsSensor() || contact->GetFixtureB()->IsSensor())
+	{
+		UpdateOverlap(contact, false);
+	}
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 
 #include "box2d\box2d.h"
 
+#include <vector>
+#include <deque>
+
 #define GRAVITY_X 0.0f
 #define GRAVITY_Y -0.6f
 
@@ -14,16 +17,38 @@
 #define METERS_TO_PIXELS(m) ((int) floor(PIXELS_PER_METER * m))
 #define PIXEL_TO_METERS(p)  ((float) METER_PER_PIXEL * p)
 
+#define PHYSICS_TIMESTEP (1.0f / 60.0f) // Fixed simulation step, independent of the render FPS
+#define PHYSICS_VELOCITY_ITERATIONS 6
+#define PHYSICS_POSITION_ITERATIONS 2
+#define PHYSICS_MAX_STEPS 5 // Max steps per frame, avoids the spiral of death when a frame takes too long
+#define PHYSICS_MAX_EVENTS 64 // Collision events buffered during one step, the rest are dropped
+#define PHYSICS_MAX_SUBSTEPS 8 // A fast ball splits a step in up to this many
+#define PHYSICS_SUBSTEP_TRAVEL 0.5f // Fraction of its diameter plus the thinnest wall near it a ball may move in one sub-step
+
+// Handles are a pool slot index plus the generation of the slot, a handle to a destroyed body stops resolving
+// Generation 0 is never used, so a zero handle is always invalid
+#define BODY_HANDLE_INDEX_BITS 20
+#define BODY_HANDLE_INDEX_MASK ((1u << BODY_HANDLE_INDEX_BITS) - 1)
+#define BODY_HANDLE_GENERATION_MASK ((1u << (32 - BODY_HANDLE_INDEX_BITS)) - 1)
+
+typedef uint32 BodyHandle;
+
 
 // Small class to return to other modules to track position and rotation of physics bodies
 class PhysBody
 {
 public:
-	PhysBody() : listener(NULL), body(NULL) {}
+	PhysBody() : listener(NULL), body(NULL), id(0), handle(0), interpolated(false), previous_angle(0.0f), render_angle(0.0f) {}
 
 	// Void GetPosition(int& x, int& y) const;
 	void GetPhysicPosition(int& x, int& y) const;
 	float GetRotation() const;
+
+	// Position and rotation to draw with, interpolated between the last two physics steps
+	void GetRenderPosition(int& x, int& y) const;
+	float GetRenderRotation() const;
+	void ResetInterpolation();
+
 	bool Contains(int x, int y) const;
 	int RayCast(int x1, int y1, int x2, int y2, float& normal_x, float& normal_y) const;
 
@@ -31,9 +56,42 @@ public:
 	int width, height;
 	b2Body* body;
 	Module* listener;
-	int id;
+	int id;			// Interaction of the body, fixtures carry their own in their user data
+	BodyHandle handle;	// Also stored in the Box2D body user data
+
+	bool interpolated;
+	b2Vec2 previous_position;
+	float previous_angle;
+	b2Vec2 render_position;
+	float render_angle;
+};
+
+
+enum CollisionEventType
+{
+	COLLISION_BEGIN,
+	SENSOR_ENTER,
+	SENSOR_EXIT
+};
+
+// A contact reported by Box2D, delivered to the listener once the step is over
+struct CollisionEvent
+{
+	CollisionEventType type;
+	Module* listener;
+	BodyHandle body;
+	BodyHandle other;
+	int dir;
 };
 
+// A body inside a sensor, it can touch it through several fixtures at once
+struct SensorOverlap
+{
+	BodyHandle sensor;
+	const b2Fixture* fixture;	// Only compared, never read
+	BodyHandle other;
+	int contacts;
+};
 
 class ModulePhysics : public Module, public b2ContactListener
 {
@@ -48,22 +106,87 @@ public:
 	bool CleanUp();
 
 	PhysBody* CreateCircle(int x, int y, int radius, b2BodyType bType);
+	// Dynamic circle with continuous collision against the flippers and the spring, its speed sets the sub-steps
+	PhysBody* CreateBall(int x, int y, int radius);
 	void CreateScenarioGround();
 	PhysBody* CreateRectangle(int x, int y, int width, int height, b2BodyType bType, int inf);
 	PhysBody* CreateRectangleSensor(int x, int y, int width, int height, b2BodyType bType, int inf);
-	PhysBody* CreateChain(int x, int y, const int* points, int size, b2BodyType bType, int inf);
 	b2RevoluteJoint* CreateFlipper(PhysBody* bodyA, PhysBody* bodyB, b2Vec2 anchor);
 	b2PrismaticJoint* CreateSpring(PhysBody* bodyA, PhysBody* bodyB, b2Vec2 axis);
-	PhysBody* CreateBumper(int x, int y, int radius, b2BodyType bType, int inf);
 
+	// Static geometry is added as fixtures of one body, so the solver has a single static body to walk
+	// The interaction id goes in the fixture user data, contacts report that one
+	PhysBody* GetStaticBody() const;
+	// Closed loop, the vertices are in meters
+	// Solid loops are as thick as the area they enclose, the board outline only has the balls inside it
+	b2Fixture* AddStaticChain(const b2Vec2* vertices, int count, int inf, bool solid);
+	b2Fixture* AddStaticSensor(int x, int y, int width, int height, int inf);
+	b2Fixture* AddStaticBumper(int x, int y, int radius, int inf);
+	void SetFixtureEnabled(b2Fixture* fixture, bool enabled);
+	static int GetInteraction(b2Fixture* fixture);
+
+	// Bodies added here are drawn interpolated between physics steps
+	void AddInterpolatedBody(PhysBody* pbody);
+
+	// Destroys the Box2D body and gives its PhysBody back to the pool, the rest go with the world on CleanUp
+	void DestroyBody(PhysBody* pbody);
+	// NULL once the body is destroyed, even if its slot was reused
+	PhysBody* GetBody(BodyHandle handle);
+	PhysBody* GetBody(b2Body* body);
+	uint GetBodyCount() const;
+
+	// Rough width of the wall a fixture makes, in meters, worked out when the fixture is made
+	static float GetThickness(b2Fixture* fixture);
+
+	// Checksum of the world, to tell if a replay reached the same state as its recording
+	uint32 GetStateHash() const;
+
+	// Only queue the contact, no game code runs inside the step
 	void BeginContact(b2Contact* contact);
+	void EndContact(b2Contact* contact);
+	// Hands the queued contacts to their listeners, after every step
+	void DispatchCollisions();
+
+	// For tools that step or query the world themselves, like the benchmarks
+	b2World* GetWorld() const;
+
+	// Bodies currently inside the sensor
+	uint GetOverlapCount(const PhysBody* sensor) const;
+
 	bool debug = false;
 
-	
 
 private:
+	void Step();
+	void StoreInterpolationStates();
+	void InterpolateBodies(float alpha);
+	PhysBody* AllocateBody();
+	void UpdateOverlap(b2Contact* contact, bool touching);
+	void QueueCollision(CollisionEventType type, Module* listener, PhysBody* body, PhysBody* other, int dir);
+	int GetSubsteps();
+
 	b2World* world;
 	b2MouseJoint* mouse_joint;
-	b2Body* ground;
+	PhysBody* static_body = NULL;
+
+	float accumulator;
+	std::vector<PhysBody*> balls;
+
+	uint substeps;			// Total world steps and fixed steps, their ratio is logged on CleanUp
+	uint fixed_steps;
+	std::vector<PhysBody*> interpolated_bodies;
+
+	// Every PhysBody lives here, a deque never moves its elements so the pointers handed out stay valid
+	std::deque<PhysBody> body_pool;
+	std::vector<uint> body_generations;
+	std::vector<uint> free_bodies;
+
+	// Ring buffer filled by BeginContact() and emptied after every step
+	CollisionEvent events[PHYSICS_MAX_EVENTS];
+	uint event_head;
+	uint event_count;
+	uint dropped_events;	// Did not fit in the buffer, logged on CleanUp
 
+	// Sensor and body pairs touching right now, only changed on begin and end of contact
+	std::vector<SensorOverlap> overlaps;
 };
\ No newline at end of file
@@ -4,10 +4,32 @@
 #include "ModuleRender.h"
 #include "ModulePhysics.h"
 #include <math.h>
+#include <string.h>
+#include <algorithm>
+
+// Lines are a different primitive, raylib flushes its batch when switching to or from them
+#define LINES_BATCH 0xFFFFFF
+
+// Texture the command is batched with, shapes use the raylib default one
+static uint GetBatch(const RenderCommand& command)
+{
+    switch (command.type)
+    {
+    case RENDER_TEXTURE: return command.texture.id;
+    case RENDER_TEXT: return command.font.texture.id;
+    case RENDER_LINE:
+    case RENDER_CIRCLE_LINES: return LINES_BATCH;
+    default: return 0;
+    }
+}
 
 ModuleRender::ModuleRender(Application* app, bool start_enabled) : Module(app, start_enabled)
 {
     background = RAYWHITE;
+    camera = { 0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+
+    recording = &snapshots[0];
+    presenting = &snapshots[1];
 }
 
 // Destructor
@@ -32,24 +54,24 @@ update_status ModuleRender::PreUpdate()
 // Update: debug camera
 update_status ModuleRender::Update()
 {
-    ClearBackground(background);
-
-    // NOTE: This function setups render batching system for
-    // maximum performance, all consecutive Draw() calls are
-    // not processed until EndDrawing() is called
-    BeginDrawing();
-
 	return UPDATE_CONTINUE;
 }
 
 // PostUpdate present buffer to screen
 update_status ModuleRender::PostUpdate()
 {
-    // Draw everything in our batch!
+    BeginDrawing();
+    ClearBackground(background);
+
+    // Draw everything recorded by the last simulation tick, grouped by layer and texture
+    Sort(*presenting);
+    draw_calls = Present(*presenting);
+
     if (App->physics->debug) {
        DrawFPS(10, 10);
+       ::DrawText(TextFormat("%u draw calls, %u commands", draw_calls, (uint)presenting->commands.size()), 10, 34, 10, WHITE);
+       DrawProfiler(10, 50);
     }
-    
 
     EndDrawing();
 
@@ -67,8 +89,118 @@ void ModuleRender::SetBackgroundColor(Color color)
 	background = color;
 }
 
+void RenderSnapshot::Clear()
+{
+    commands.clear();
+    text.clear();
+}
+
+void ModuleRender::SwapSnapshots()
+{
+    RenderSnapshot* last = recording;
+    recording = presenting;
+    presenting = last;
+
+    recording->Clear();
+}
+
+// Stamp the command with its sort key: layer, then texture, then the order it was recorded in
+void ModuleRender::Record(RenderCommand& command, RenderLayer layer)
+{
+    uint64 sequence = (uint64)recording->commands.size();
+    command.key = ((uint64)layer << 56) | ((uint64)(GetBatch(command) & LINES_BATCH) << 32) | (sequence & 0xFFFFFFFF);
+
+    recording->commands.push_back(command);
+}
+
+// Keys are unique, so the order is the same every frame for the same commands
+void ModuleRender::Sort(RenderSnapshot& snapshot) const
+{
+    std::sort(snapshot.commands.begin(), snapshot.commands.end(), [](const RenderCommand& a, const RenderCommand& b) { return a.key < b.key; });
+}
+
+// Returns how many times the batch had to be flushed for a different texture or primitive
+uint ModuleRender::Present(const RenderSnapshot& snapshot) const
+{
+    uint batches = 0;
+    uint last_batch = UINT_MAX;
+
+    for (const RenderCommand& command : snapshot.commands)
+    {
+        uint batch = GetBatch(command);
+        if (batch != last_batch)
+        {
+            batches++;
+            last_batch = batch;
+        }
+
+        switch (command.type)
+        {
+        case RENDER_TEXTURE:
+            DrawTexturePro(command.texture, command.source, command.dest, command.origin, command.rotation, command.tint);
+            break;
+
+        case RENDER_TEXT:
+            DrawTextEx(command.font, &snapshot.text[command.text], Vector2{ command.dest.x, command.dest.y }, command.size, command.spacing, command.tint);
+            break;
+
+        case RENDER_RECTANGLE:
+            DrawRectangleRec(command.dest, command.tint);
+            break;
+
+        case RENDER_LINE:
+            ::DrawLine((int)command.dest.x, (int)command.dest.y, (int)command.dest.width, (int)command.dest.height, command.tint);
+            break;
+
+        case RENDER_CIRCLE_LINES:
+            ::DrawCircleLines((int)command.dest.x, (int)command.dest.y, command.size, command.tint);
+            break;
+        }
+    }
+
+    return batches;
+}
+
+// Per module min/avg/p99 over the profiler window, Render PostUpdate includes the frame limiter wait
+void ModuleRender::DrawProfiler(int x, int y) const
+{
+    const Profiler& profiler = App->profiler;
+    const int line_height = 12;
+    const int font_size = 10;
+    const int columns[5] = { x, x + 50, x + 130, x + 180, x + 230 };
+
+    int lines = profiler.GetTrackCount() * PROFILE_PHASE_COUNT + 2;
+    ::DrawRectangle(x - 4, y - 4, 280, lines * line_height + 8, Fade(BLACK, 0.6f));
+
+    ::DrawText("ms", columns[1], y, font_size, WHITE);
+    ::DrawText("min", columns[2], y, font_size, WHITE);
+    ::DrawText("avg", columns[3], y, font_size, WHITE);
+    ::DrawText("p99", columns[4], y, font_size, WHITE);
+    y += line_height;
+
+    for (int track = 0; track <= profiler.GetTrackCount(); ++track)
+    {
+        bool frame = (track == profiler.GetTrackCount());
+        int phases = frame ? 1 : PROFILE_PHASE_COUNT;
+
+        for (int phase = 0; phase < phases; ++phase)
+        {
+            ProfilerStats stats = frame ? profiler.GetFrameStats() : profiler.GetStats(track, (ProfilerPhase)phase);
+            Color color = frame ? GREEN : (stats.p99 > 1.0f) ? YELLOW : WHITE;
+
+            if (phase == 0) ::DrawText(frame ? "Frame" : profiler.GetTrackName(track), columns[0], y, font_size, color);
+            if (!frame) ::DrawText(Profiler::GetPhaseName((ProfilerPhase)phase), columns[1], y, font_size, color);
+            ::DrawText(TextFormat("%.2f", stats.min), columns[2], y, font_size, color);
+            ::DrawText(TextFormat("%.2f", stats.avg), columns[3], y, font_size, color);
+            ::DrawText(TextFormat("%.2f", stats.p99), columns[4], y, font_size, color);
+            y += line_height;
+        }
+    }
+}
+
+
 // Draw to screen
-bool ModuleRender::Draw(Texture2D texture, int x, int y, const Rectangle* section, double angle, int pivot_x, int pivot_y) const
+bool ModuleRender::Draw(Texture2D texture, int x, int y, RenderLayer layer, const Rectangle* section, double angle, int pivot_x, int pivot_y)
 {
 	bool ret = true;
 
@@ -84,18 +216,102 @@ bool ModuleRender::Draw(Texture2D texture, int x, int y, const Rectangle* sectio
 	rect.width *= scale;
 	rect.height *= scale;
 
-    DrawTextureRec(texture, rect, position, WHITE);
+    DrawSprite(texture, rect, Rectangle{ position.x, position.y, fabsf(rect.width), fabsf(rect.height) }, Vector2{ 0.0f, 0.0f }, 0.0f, WHITE, layer);
 
 	return ret;
 }
 
-bool ModuleRender::DrawText(const char * text, int x, int y, Font font, int spacing, Color tint) const
+bool ModuleRender::Draw(const Sprite& sprite, int x, int y, RenderLayer layer)
 {
-    bool ret = true;
+    Rectangle source = { 0.0f, 0.0f, sprite.rect.width, sprite.rect.height };
+    DrawSprite(sprite, source, Rectangle{ (float)x + camera.x, (float)y + camera.y, sprite.rect.width, sprite.rect.height }, Vector2{ 0.0f, 0.0f }, 0.0f, WHITE, layer);
 
-    Vector2 position = { (float)x, (float)y };
+    return IsEnabled();
+}
+
+bool ModuleRender::DrawText(const char * text, int x, int y, Font font, int spacing, Color tint, RenderLayer layer)
+{
+    return DrawText(text, Vector2{ (float)x, (float)y }, font, (float)font.baseSize, (float)spacing, tint, layer);
+}
+
+bool ModuleRender::DrawText(const char* text, Vector2 position, Font font, float size, float spacing, Color tint, RenderLayer layer)
+{
+    if (!IsEnabled()) return false;
+
+    // The caller buffer can change before the snapshot is presented, keep a copy
+    RenderCommand command = {};
+    command.type = RENDER_TEXT;
+    command.tint = tint;
+    command.dest = { position.x, position.y, 0.0f, 0.0f };
+    command.font = font;
+    command.size = size;
+    command.spacing = spacing;
+    command.text = (uint)recording->text.size();
+
+    recording->text.insert(recording->text.end(), text, text + strlen(text) + 1);
+    Record(command, layer);
+
+    return true;
+}
+
+void ModuleRender::DrawSprite(Texture2D texture, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint, RenderLayer layer)
+{
+    if (!IsEnabled()) return;
+
+    RenderCommand command = {};
+    command.type = RENDER_TEXTURE;
+    command.tint = tint;
+    command.texture = texture;
+    command.source = source;
+    command.dest = dest;
+    command.origin = origin;
+    command.rotation = rotation;
+
+    Record(command, layer);
+}
+
+// Source is relative to the sprite area
+void ModuleRender::DrawSprite(const Sprite& sprite, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint, RenderLayer layer)
+{
+    source.x += sprite.rect.x;
+    source.y += sprite.rect.y;
+
+    DrawSprite(sprite.texture, source, dest, origin, rotation, tint, layer);
+}
+
+void ModuleRender::DrawRectangle(Rectangle rect, Color color, RenderLayer layer)
+{
+    if (!IsEnabled()) return;
+
+    RenderCommand command = {};
+    command.type = RENDER_RECTANGLE;
+    command.tint = color;
+    command.dest = rect;
+
+    Record(command, layer);
+}
+
+void ModuleRender::DrawLine(int x1, int y1, int x2, int y2, Color color, RenderLayer layer)
+{
+    if (!IsEnabled()) return;
+
+    RenderCommand command = {};
+    command.type = RENDER_LINE;
+    command.tint = color;
+    command.dest = { (float)x1, (float)y1, (float)x2, (float)y2 };
+
+    Record(command, layer);
+}
+
+void ModuleRender::DrawCircleLines(int x, int y, float radius, Color color, RenderLayer layer)
+{
+    if (!IsEnabled()) return;
 
-    DrawTextEx(font, text, position, (float)font.baseSize, (float)spacing, tint);
+    RenderCommand command = {};
+    command.type = RENDER_CIRCLE_LINES;
+    command.tint = color;
+    command.dest = { (float)x, (float)y, 0.0f, 0.0f };
+    command.size = radius;
 
-    return ret;
+    Record(command, layer);
 }
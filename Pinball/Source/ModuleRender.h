@@ -3,6 +3,64 @@
 #include "Globals.h"
 
 #include <limits.h>
+#include <vector>
+
+// An area of a texture, usually a frame packed in an atlas page
+struct Sprite
+{
+	Texture2D texture = {};
+	Rectangle rect = {};
+};
+
+// Draw order, commands are sorted by layer and then by texture inside a layer
+// Overlapping draws that must keep their order need different layers (or the same texture)
+enum RenderLayer
+{
+	LAYER_BOARD,
+	LAYER_ENTITIES,
+	LAYER_BALL,
+	LAYER_FLIPPERS,
+	LAYER_UI,
+	LAYER_TEXT,
+	LAYER_DEBUG
+};
+
+enum RenderCommandType
+{
+	RENDER_TEXTURE,
+	RENDER_TEXT,
+	RENDER_RECTANGLE,
+	RENDER_LINE,
+	RENDER_CIRCLE_LINES
+};
+
+// A recorded draw call with everything needed to replay it later
+struct RenderCommand
+{
+	RenderCommandType type;
+	Color tint;
+	uint64 key;			// Layer, texture and record order, see ModuleRender::Record()
+
+	Texture2D texture;
+	Rectangle source;
+	Rectangle dest;		// Texture and rectangle area, line start (x, y) and end (width, height), circle center (x, y)
+	Vector2 origin;
+	float rotation;
+
+	Font font;
+	float size;			// Text size, circle radius
+	float spacing;
+	uint text;			// Offset of the string in RenderSnapshot::text
+};
+
+// Draw calls of one simulation tick, never modified while it is being presented
+struct RenderSnapshot
+{
+	std::vector<RenderCommand> commands;
+	std::vector<char> text;
+
+	void Clear();
+};
 
 class ModuleRender : public Module
 {
@@ -17,11 +75,39 @@ public:
 	bool CleanUp();
 
     void SetBackgroundColor(Color color);
-	bool Draw(Texture2D texture, int x, int y, const Rectangle* section = NULL, double angle = 0, int pivot_x = 0, int pivot_y = 0) const;
-    bool DrawText(const char* text, int x, int y, Font font, int spacing, Color tint) const;
+
+    // Recorded into the current snapshot and drawn when it is presented
+	bool Draw(Texture2D texture, int x, int y, RenderLayer layer = LAYER_UI, const Rectangle* section = NULL, double angle = 0, int pivot_x = 0, int pivot_y = 0);
+	bool Draw(const Sprite& sprite, int x, int y, RenderLayer layer = LAYER_UI);
+    bool DrawText(const char* text, int x, int y, Font font, int spacing, Color tint, RenderLayer layer = LAYER_TEXT);
+    bool DrawText(const char* text, Vector2 position, Font font, float size, float spacing, Color tint, RenderLayer layer = LAYER_TEXT);
+    void DrawSprite(Texture2D texture, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint, RenderLayer layer = LAYER_ENTITIES);
+    void DrawSprite(const Sprite& sprite, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint, RenderLayer layer = LAYER_ENTITIES);
+    void DrawRectangle(Rectangle rect, Color color, RenderLayer layer = LAYER_UI);
+    void DrawLine(int x1, int y1, int x2, int y2, Color color, RenderLayer layer = LAYER_DEBUG);
+    void DrawCircleLines(int x, int y, float radius, Color color, RenderLayer layer = LAYER_DEBUG);
+
+    // The recorded snapshot becomes the presented one, recording restarts on the other
+    void SwapSnapshots();
+
+private:
+
+    void Record(RenderCommand& command, RenderLayer layer);
+    void Sort(RenderSnapshot& snapshot) const;
+    uint Present(const RenderSnapshot& snapshot) const;
+    void DrawProfiler(int x, int y) const;
 
 public:
 
 	Color background;
     Rectangle camera;
+
+private:
+
+    RenderSnapshot snapshots[2];
+    RenderSnapshot* recording;
+    RenderSnapshot* presenting;
+
+    // Texture and primitive switches of the last presented frame, for the debug overlay
+    uint draw_calls = 0;
 };
\ No newline at end of file
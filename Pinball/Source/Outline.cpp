@@ -0,0 +1,268 @@
+#include "Outline.h"
+#include "Table.h"
+#include "ModulePhysics.h"
+
+#include <math.h>
+#include <algorithm>
+#include <unordered_map>
+
+// Edge midpoints of a marching squares cell, in doubled mask coordinates so they stay integers
+struct OutlineSegment
+{
+	int x1, y1;
+	int x2, y2;
+	bool used;
+};
+
+static long long PointKey(int x, int y)
+{
+	return ((long long)y << 32) | (uint32)x;
+}
+
+std::vector<Outline> TraceOutlines(const std::vector<bool>& solid, int width, int height)
+{
+	auto sample = [&](int x, int y) { return x >= 0 && y >= 0 && x < width && y < height && solid[y * width + x]; };
+
+	std::vector<OutlineSegment> segments;
+
+	// Cell (x, y) has the pixel centres (x, y), (x + 1, y), (x + 1, y + 1) and (x, y + 1) as corners, clockwise
+	for (int y = -1; y < height; ++y)
+	{
+		for (int x = -1; x < width; ++x)
+		{
+			bool corners[4] = { sample(x, y), sample(x + 1, y), sample(x + 1, y + 1), sample(x, y + 1) };
+			int corner_x[4] = { 2 * x + 1, 2 * x + 3, 2 * x + 3, 2 * x + 1 };
+			int corner_y[4] = { 2 * y + 1, 2 * y + 1, 2 * y + 3, 2 * y + 3 };
+
+			int count = corners[0] + corners[1] + corners[2] + corners[3];
+			if (count == 0 || count == 4) continue;
+
+			// Edge midpoints next to corner i, towards the previous and the next corner
+			auto before = [&](int i, int& px, int& py) { px = (corner_x[i] + corner_x[(i + 3) % 4]) / 2; py = (corner_y[i] + corner_y[(i + 3) % 4]) / 2; };
+			auto after = [&](int i, int& px, int& py) { px = (corner_x[i] + corner_x[(i + 1) % 4]) / 2; py = (corner_y[i] + corner_y[(i + 1) % 4]) / 2; };
+
+			for (int i = 0; i < 4; ++i)
+			{
+				int next = (i + 1) % 4;
+				int ax, ay, bx, by;
+				int reference;
+
+				if (count == 2 && corners[i] && corners[next])
+				{
+					// Two neighbouring solid corners, one segment across the cell
+					before(i, ax, ay);
+					after(next, bx, by);
+					reference = i;
+				}
+				else if ((count == 1 && corners[i]) || (count == 3 && !corners[i]))
+				{
+					// The odd corner is cut off
+					before(i, ax, ay);
+					after(i, bx, by);
+					reference = corners[i] ? i : next;
+				}
+				else if (count == 2 && !corners[i] && corners[next] && corners[(i + 3) % 4])
+				{
+					// Diagonal corners, both empty ones are cut off so the walls stay joined
+					before(i, ax, ay);
+					after(i, bx, by);
+					reference = next;
+				}
+				else continue;
+
+				// Box2D chains collide on the right of each edge, the solid side has to be on the left
+				int normal_x = by - ay;
+				int normal_y = -(bx - ax);
+				if (normal_x * (corner_x[reference] - ax) + normal_y * (corner_y[reference] - ay) > 0)
+				{
+					std::swap(ax, bx);
+					std::swap(ay, by);
+				}
+
+				segments.push_back(OutlineSegment{ ax, ay, bx, by, false });
+			}
+		}
+	}
+
+	// Every midpoint starts exactly one segment, following them closes the loops
+	std::unordered_map<long long, uint> starts;
+	starts.reserve(segments.size());
+	for (uint i = 0; i < segments.size(); ++i) starts[PointKey(segments[i].x1, segments[i].y1)] = i;
+
+	std::vector<Outline> outlines;
+
+	for (uint first = 0; first < segments.size(); ++first)
+	{
+		if (segments[first].used) continue;
+
+		Outline loop;
+		uint current = first;
+
+		while (!segments[current].used)
+		{
+			OutlineSegment& segment = segments[current];
+			segment.used = true;
+			loop.push_back(Vector2{ segment.x1 * 0.5f, segment.y1 * 0.5f });
+
+			auto next = starts.find(PointKey(segment.x2, segment.y2));
+			if (next == starts.end()) break;
+			current = next->second;
+		}
+
+		if (loop.size() >= 3) outlines.push_back(loop);
+	}
+
+	return outlines;
+}
+
+static float DistanceToSegment(const Vector2& p, const Vector2& a, const Vector2& b)
+{
+	float dx = b.x - a.x, dy = b.y - a.y;
+	float length = dx * dx + dy * dy;
+	float t = (length > 0.0f) ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / length : 0.0f;
+	t = MAX(0.0f, MIN(t, 1.0f));
+
+	float x = a.x + t * dx - p.x, y = a.y + t * dy - p.y;
+	return sqrtf(x * x + y * y);
+}
+
+// Marks the vertices of loop[first..last] that Douglas-Peucker keeps, without recursion, outlines get long
+static void SimplifyRange(const Outline& loop, uint first, uint last, float tolerance, std::vector<bool>& keep)
+{
+	uint count = (uint)loop.size();
+	std::vector<std::pair<uint, uint>> ranges(1, std::make_pair(first, last));
+
+	while (!ranges.empty())
+	{
+		uint a = ranges.back().first, b = ranges.back().second;
+		ranges.pop_back();
+
+		float furthest = 0.0f;
+		uint split = a;
+
+		for (uint i = (a + 1) % count; i != b; i = (i + 1) % count)
+		{
+			float distance = DistanceToSegment(loop[i], loop[a], loop[b]);
+			if (distance > furthest)
+			{
+				furthest = distance;
+				split = i;
+			}
+		}
+
+		if (furthest > tolerance)
+		{
+			keep[split] = true;
+			ranges.push_back(std::make_pair(a, split));
+			ranges.push_back(std::make_pair(split, b));
+		}
+	}
+}
+
+Outline SimplifyOutline(const Outline& loop, float tolerance)
+{
+	uint count = (uint)loop.size();
+	if (count < 4) return loop;
+
+	// A closed loop is split in two at its two furthest apart vertices, each half is an open polyline
+	uint a = 0, b = 0;
+	float furthest = 0.0f;
+
+	for (uint i = 1; i < count; ++i)
+	{
+		float dx = loop[i].x - loop[0].x, dy = loop[i].y - loop[0].y;
+		if (dx * dx + dy * dy > furthest)
+		{
+			furthest = dx * dx + dy * dy;
+			b = i;
+		}
+	}
+
+	std::vector<bool> keep(count, false);
+	keep[a] = keep[b] = true;
+
+	SimplifyRange(loop, a, b, tolerance, keep);
+	SimplifyRange(loop, b, a, tolerance, keep);
+
+	Outline simplified;
+	for (uint i = 0; i < count; ++i)
+	{
+		if (keep[i]) simplified.push_back(loop[i]);
+	}
+
+	return simplified;
+}
+
+bool TraceTable(const char* source, const char* mask, const char* destination, float tolerance)
+{
+	TableSource table;
+	if (Table::Parse(source, table) == false) return false;
+
+	Image board = LoadImage(table.header.texture);
+	Image image = LoadImage(mask);
+
+	if (board.data == NULL || image.data == NULL)
+	{
+		LOG("Cannot load %s or %s", table.header.texture, mask);
+		UnloadImage(board);
+		UnloadImage(image);
+		return false;
+	}
+
+	// The board is drawn at twice its size, the mask covers the same area
+	float scale = board.width * 2.0f / image.width;
+
+	Color* colors = LoadImageColors(image);
+	std::vector<bool> solid(image.width * image.height);
+	for (uint i = 0; i < solid.size(); ++i) solid[i] = colors[i].a >= 128 && (colors[i].r + colors[i].g + colors[i].b) >= 3 * 128;
+
+	std::vector<Outline> outlines = TraceOutlines(solid, image.width, image.height);
+
+	UnloadImageColors(colors);
+	UnloadImage(image);
+	UnloadImage(board);
+
+	// Walls with an interaction (impulsers, the blocker) stay as they were written
+	std::vector<TableChain> chains;
+	std::vector<TableVertex> vertices;
+	uint replaced = 0;
+
+	for (const TableChain& chain : table.chains)
+	{
+		if (chain.interaction == TABLE_PLAIN_WALL && chain.kind != TABLE_CHAIN_BLOCKER)
+		{
+			replaced += chain.vertex_count;
+			continue;
+		}
+
+		chains.push_back(TableChain{ chain.kind, chain.interaction, (uint32)vertices.size(), chain.vertex_count });
+		vertices.insert(vertices.end(), table.vertices.begin() + chain.first_vertex, table.vertices.begin() + chain.first_vertex + chain.vertex_count);
+	}
+
+	// The longest outline is the board, the game needs one
+	uint traced = 0, kept = 0;
+	uint longest = 0;
+	for (uint i = 0; i < outlines.size(); ++i)
+	{
+		if (outlines[i].size() > outlines[longest].size()) longest = i;
+	}
+
+	for (uint i = 0; i < outlines.size(); ++i)
+	{
+		Outline simplified = SimplifyOutline(outlines[i], tolerance);
+		traced += (uint)outlines[i].size();
+		if (simplified.size() < 3) continue;
+
+		chains.push_back(TableChain{ (uint32)((i == longest) ? TABLE_CHAIN_BOARD : TABLE_CHAIN_OBSTACLE), TABLE_PLAIN_WALL, (uint32)vertices.size(), (uint32)simplified.size() });
+		for (const Vector2& point : simplified) vertices.push_back(TableVertex{ PIXEL_TO_METERS(point.x * scale), PIXEL_TO_METERS(point.y * scale) });
+		kept += (uint)simplified.size();
+	}
+
+	table.chains = chains;
+	table.vertices = vertices;
+
+	printf("Traced %u outlines from %s: %u vertices, %u after simplifying (tolerance %.2f), the hand traced walls had %u\n",
+		(uint)outlines.size(), mask, traced, kept, tolerance, replaced);
+
+	return Table::Write(destination, table);
+}
\ No newline at end of file
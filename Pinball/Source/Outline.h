@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <vector>
+
+#define OUTLINE_TOLERANCE 1.5f // Default Douglas-Peucker tolerance of -trace-table, in mask pixels
+
+typedef std::vector<Vector2> Outline;
+
+// Marching squares over the solid pixels of a width * height mask, outside the mask counts as empty
+// Points are in mask pixels, every loop is wound with the solid on its left so chain normals point out of the walls
+std::vector<Outline> TraceOutlines(const std::vector<bool>& solid, int width, int height);
+
+// Douglas-Peucker on a closed loop: keeps the vertices further than tolerance from the simplified outline
+Outline SimplifyOutline(const Outline& loop, float tolerance);
+
+// Replaces the plain walls of a table source with the outlines of a collision mask, white walls on black
+// The mask can be any size, it is stretched over the board image named in the source
+bool TraceTable(const char* source, const char* mask, const char* destination, float tolerance);
\ No newline at end of file
@@ -0,0 +1,32 @@
+// ----------------------------------------------------
+// High resolution timer with nanosecond ticks
+// ----------------------------------------------------
+
+#include "PerfTimer.h"
+
+#include <chrono>
+
+static uint64 NowTicks()
+{
+	return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PerfTimer::PerfTimer()
+{
+	Start();
+}
+
+void PerfTimer::Start()
+{
+	started_at = NowTicks();
+}
+
+double PerfTimer::ReadMs() const
+{
+	return (double)(NowTicks() - started_at) / 1000000.0;
+}
+
+uint64 PerfTimer::ReadTicks() const
+{
+	return NowTicks() - started_at;
+}
\ No newline at end of file
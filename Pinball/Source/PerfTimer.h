@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Globals.h"
+
+// High resolution monotonic timer, for profiling
+class PerfTimer
+{
+public:
+
+	// Constructor
+	PerfTimer();
+
+	void Start();
+	double ReadMs() const;
+	uint64 ReadTicks() const;
+
+private:
+
+	// Start time in nanoseconds
+	uint64 started_at;
+};
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "Profiler.h"
+
+#include <string.h>
+#include <algorithm>
+
+static const char* phase_names[PROFILE_PHASE_COUNT] = { "PreUpdate", "Update", "PostUpdate" };
+
+int Profiler::AddTrack(const char* name)
+{
+	Track track;
+	track.name = name;
+	memset(track.samples, 0, sizeof(track.samples));
+	tracks.push_back(track);
+
+	return (int)tracks.size() - 1;
+}
+
+// Clear the slot of this frame, modules that are disabled or skipped keep a zero sample
+void Profiler::BeginFrame()
+{
+	for (Track& track : tracks)
+	{
+		for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+		{
+			track.samples[phase][cursor] = 0.0f;
+		}
+	}
+	frame_samples[cursor] = 0.0f;
+}
+
+void Profiler::AddSample(int track, ProfilerPhase phase, float ms)
+{
+	tracks[track].samples[phase][cursor] = ms;
+}
+
+void Profiler::SetFrameTime(float ms)
+{
+	frame_samples[cursor] = ms;
+}
+
+void Profiler::EndFrame()
+{
+	cursor = (cursor + 1) % PROFILER_SAMPLES;
+	frames++;
+}
+
+int Profiler::GetTrackCount() const
+{
+	return (int)tracks.size();
+}
+
+const char* Profiler::GetTrackName(int track) const
+{
+	return tracks[track].name;
+}
+
+ProfilerStats Profiler::GetStats(int track, ProfilerPhase phase) const
+{
+	return ComputeStats(tracks[track].samples[phase]);
+}
+
+ProfilerStats Profiler::GetFrameStats() const
+{
+	return ComputeStats(frame_samples);
+}
+
+const char* Profiler::GetPhaseName(ProfilerPhase phase)
+{
+	return phase_names[phase];
+}
+
+uint Profiler::GetValidSamples() const
+{
+	return (frames < PROFILER_SAMPLES) ? (uint)frames : PROFILER_SAMPLES;
+}
+
+ProfilerStats Profiler::ComputeStats(const float* samples) const
+{
+	ProfilerStats stats;
+
+	uint count = GetValidSamples();
+	if (count == 0) return stats;
+
+	// Until the ring wraps the valid samples are the first ones
+	float sorted[PROFILER_SAMPLES];
+	memcpy(sorted, samples, count * sizeof(float));
+	std::sort(sorted, sorted + count);
+
+	float total = 0.0f;
+	for (uint i = 0; i < count; ++i) total += sorted[i];
+
+	stats.min = sorted[0];
+	stats.avg = total / count;
+	stats.p99 = sorted[((count - 1) * 99) / 100];
+
+	return stats;
+}
+
+// One row per frame, oldest first, one column per module phase plus the whole frame
+bool Profiler::SaveCSV(const char* path) const
+{
+	FILE* file = NULL;
+	if (fopen_s(&file, path, "w") != 0 || file == NULL)
+	{
+		LOG("Could not open profiler output %s", path);
+		return false;
+	}
+
+	fprintf(file, "frame");
+	for (const Track& track : tracks)
+	{
+		for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+		{
+			fprintf(file, ",%s %s", track.name, phase_names[phase]);
+		}
+	}
+	fprintf(file, ",Frame\n");
+
+	uint count = GetValidSamples();
+	uint first = (frames < PROFILER_SAMPLES) ? 0 : cursor;
+
+	for (uint i = 0; i < count; ++i)
+	{
+		uint slot = (first + i) % PROFILER_SAMPLES;
+
+		fprintf(file, "%llu", (unsigned long long)(frames - count + i));
+		for (const Track& track : tracks)
+		{
+			for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+			{
+				fprintf(file, ",%.4f", track.samples[phase][slot]);
+			}
+		}
+		fprintf(file, ",%.4f\n", frame_samples[slot]);
+	}
+
+	fclose(file);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <vector>
+
+// Frames kept per module, min/avg/p99 are computed over this window
+#define PROFILER_SAMPLES 256
+
+enum ProfilerPhase
+{
+	PROFILE_PRE_UPDATE = 0,
+	PROFILE_UPDATE,
+	PROFILE_POST_UPDATE,
+	PROFILE_PHASE_COUNT
+};
+
+struct ProfilerStats
+{
+	float min = 0.0f;
+	float avg = 0.0f;
+	float p99 = 0.0f;
+};
+
+// Per module ring buffers of phase timings (milliseconds), one slot per frame
+class Profiler
+{
+public:
+
+	int AddTrack(const char* name);
+
+	void BeginFrame();
+	void AddSample(int track, ProfilerPhase phase, float ms);
+	void SetFrameTime(float ms);
+	void EndFrame();
+
+	int GetTrackCount() const;
+	const char* GetTrackName(int track) const;
+	ProfilerStats GetStats(int track, ProfilerPhase phase) const;
+	ProfilerStats GetFrameStats() const;
+
+	bool SaveCSV(const char* path) const;
+
+	static const char* GetPhaseName(ProfilerPhase phase);
+
+private:
+
+	struct Track
+	{
+		const char* name;
+		float samples[PROFILE_PHASE_COUNT][PROFILER_SAMPLES];
+	};
+
+	ProfilerStats ComputeStats(const float* samples) const;
+	uint GetValidSamples() const;
+
+	std::vector<Track> tracks;
+	float frame_samples[PROFILER_SAMPLES] = {};
+
+	uint cursor = 0;
+	uint64 frames = 0;
+};
\ No newline at end of file
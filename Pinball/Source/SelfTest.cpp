@@ -0,0 +1,104 @@
+#include "SelfTest.h"
+#include "Application.h"
+#include "ModuleGame.h"
+#include "ModulePhysics.h"
+
+#include <stdio.h>
+#include <vector>
+
+struct RecordedCollision
+{
+	BodyHandle body;
+	BodyHandle other;
+	int dir;
+};
+
+// Takes the place of ModuleGame as listener, keeps what ModulePhysics hands over
+class CollisionRecorder : public Module
+{
+public:
+	CollisionRecorder(Application* app) : Module(app) {}
+
+	void OnCollision(PhysBody* bodyA, PhysBody* bodyB, int dir) override
+	{
+		collisions.push_back(RecordedCollision{ bodyA->handle, bodyB->handle, dir });
+	}
+
+	bool Received(const PhysBody* body, const PhysBody* other, int dir) const
+	{
+		for (const RecordedCollision& collision : collisions)
+		{
+			if (collision.body == body->handle && collision.other == other->handle && collision.dir == dir) return true;
+		}
+
+		return false;
+	}
+
+	std::vector<RecordedCollision> collisions;
+};
+
+// A ball dropped on each bumper is reported to both listeners with the interaction of the bumper
+// Static fixtures always end up as fixture B of their contacts, the interaction is read from that side
+static bool TestBumperCollisions(Application* App)
+{
+	ModulePhysics* physics = App->physics;
+	const Table& table = App->scene_intro->table;
+	PhysBody* table_body = physics->GetStaticBody();
+
+	CollisionRecorder recorder(App);
+	Module* table_listener = table_body->listener;
+	table_body->listener = &recorder;
+
+	bool ret = table.GetBumperCount() > 0;
+	for (uint i = 0; i < table.GetBumperCount(); ++i)
+	{
+		const TableBumper& bumper = table.GetBumper(i);
+		int radius = App->scene_intro->ballRad;
+
+		PhysBody* ball = physics->CreateBall(bumper.x, bumper.y - bumper.radius - radius - 2, radius);
+		ball->listener = &recorder;
+		ball->body->SetLinearVelocity(b2Vec2(0.0f, 2.0f));
+		recorder.collisions.clear();
+
+		bool hit = false;
+		for (uint step = 0; step < SELF_TEST_MAX_STEPS && !hit; ++step)
+		{
+			physics->GetWorld()->Step(PHYSICS_TIMESTEP, PHYSICS_VELOCITY_ITERATIONS, PHYSICS_POSITION_ITERATIONS);
+			physics->DispatchCollisions();
+			hit = recorder.Received(ball, table_body, bumper.interaction) && recorder.Received(table_body, ball, bumper.interaction);
+		}
+
+		if (!hit) printf("  bumper %u at %d, %d: no COLLISION_BEGIN with interaction %d\n", i, bumper.x, bumper.y, bumper.interaction);
+
+		physics->DestroyBody(ball);
+		ret = ret && hit;
+	}
+
+	table_body->listener = table_listener;
+	return ret;
+}
+
+bool RunSelfTests(const char* table)
+{
+	char* args[] = { (char*)"Pinball", (char*)"-headless", (char*)"-table", (char*)table };
+	Application* App = new Application(sizeof(args) / sizeof(args[0]), args);
+	App->quiet = true;
+
+	// The table is built on the first tick
+	bool ret = App->Init() && App->Update() == UPDATE_CONTINUE;
+	if (ret)
+	{
+		bool passed = TestBumperCollisions(App);
+		printf("%s bumper collisions\n", passed ? "PASS" : "FAIL");
+		ret = passed;
+	}
+	else
+	{
+		printf("FAIL cannot start a headless game on %s\n", table);
+	}
+
+	App->CleanUp();
+	delete App;
+
+	return ret;
+}
\ No newline at end of file
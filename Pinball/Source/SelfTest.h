@@ -0,0 +1,9 @@
+#pragma once
+
+#include "Globals.h"
+
+#define SELF_TEST_MAX_STEPS 120 // Physics steps a test case waits for the contact it expects
+
+// Headless checks of the game against the given table, prints PASS or FAIL for each case
+// Returns false if any case failed
+bool RunSelfTests(const char* table);
\ No newline at end of file
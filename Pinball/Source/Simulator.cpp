@@ -0,0 +1,294 @@
+#include "Simulator.h"
+#include "Application.h"
+#include "ModuleGame.h"
+#include "ModuleInput.h"
+#include "ModulePhysics.h"
+#include "Timer.h"
+
+#include "raylib.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define POLICY_FLIP_HOLD 12 // Ticks a flipper stays up after the last ball it was flipped at
+#define POLICY_FALL_SPEED 0.5f // Meters per second down a ball has to be moving to be flipped at, resting ones are left alone
+#define POLICY_REACH_MIN 30 // Pixels above the flippers a falling ball is flipped at, picked per game
+#define POLICY_REACH_MAX 90
+#define POLICY_CHARGE_MIN 20 // Ticks Spoink is charged before the launch, picked per launch
+#define POLICY_CHARGE_MAX 90
+#define POLICY_LAUNCH_WAIT 60 // Ticks left for Spoink to throw the ball before it can be charged again
+
+struct TuningSet
+{
+	char name[32];
+	TableTuning tuning;
+};
+
+struct GameResult
+{
+	bool played;
+	bool finished;	// Reached game over before SIMULATION_MAX_TICKS
+	int score;
+	uint64 ticks;
+	uint drains;
+	uint64 ball_life_ticks;
+};
+
+// Flips whichever flipper a ball is falling onto and launches every ball Spoink gets
+// Reach and charge are random, so games with the same tuning play out differently
+class FlipperPolicy
+{
+public:
+
+	FlipperPolicy(Application* app, uint seed) : app(app), random(seed)
+	{
+		int right_y;
+		app->scene_intro->table.GetSpawn("flipper_left", left_x, flipper_y);
+		app->scene_intro->table.GetSpawn("flipper_right", right_x, right_y);
+		reach = std::uniform_int_distribution<int>(POLICY_REACH_MIN, POLICY_REACH_MAX)(random);
+	}
+
+	// Keys of the next tick, from the state the last one left
+	void Tick()
+	{
+		ModuleGame* game = app->scene_intro;
+
+		bool left = false, right = false;
+		for (const ModuleGame::BallState& ball : game->balls)
+		{
+			int x, y;
+			ball.body->GetPhysicPosition(x, y);
+			if (ball.body->body->GetLinearVelocity().y < POLICY_FALL_SPEED || y < flipper_y - reach || y > flipper_y) continue;
+
+			if (x < (left_x + right_x) / 2) left = true;
+			else right = true;
+		}
+
+		left_hold = left ? POLICY_FLIP_HOLD : MAX(left_hold - 1, 0);
+		right_hold = right ? POLICY_FLIP_HOLD : MAX(right_hold - 1, 0);
+
+		// Held down while charging, the release launches, the ball touches Spoink again on its way up
+		if (wait > 0) wait--;
+
+		if (!game->canImpulse || wait > 0) charge = -1;
+		else if (charge < 0) charge = std::uniform_int_distribution<int>(POLICY_CHARGE_MIN, POLICY_CHARGE_MAX)(random);
+
+		bool down = charge > 0;
+		if (down && --charge == 0) wait = POLICY_LAUNCH_WAIT;
+
+		app->input->SetKey(KEY_LEFT, left_hold > 0);
+		app->input->SetKey(KEY_RIGHT, right_hold > 0);
+		app->input->SetKey(KEY_DOWN, down);
+	}
+
+private:
+
+	Application* app;
+	std::mt19937 random;
+
+	int left_x, right_x, flipper_y;
+	int reach;
+	int left_hold = 0;
+	int right_hold = 0;
+	int charge = -1;
+	int wait = 0;
+};
+
+// Lines are "<name> <flipper torque> <bumper restitution> <spring force> <extra life score>"
+static bool LoadSweep(const char* path, std::vector<TuningSet>& sets)
+{
+	FILE* file = NULL;
+
+	if (fopen_s(&file, path, "r") != 0 || file == NULL)
+	{
+		LOG("Cannot open tuning sweep: %s", path);
+		return false;
+	}
+
+	bool ret = true;
+
+	char line[256];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		char tokens[5][32];
+
+		const char* cursor = line;
+		int read = 0;
+		while (read < 5 && ReadToken(cursor, tokens[read], sizeof(tokens[read]))) read++;
+
+		if (read == 0 || tokens[0][0] == '#') continue;
+
+		if (read < 5)
+		{
+			LOG("Bad tuning sweep line: %s", line);
+			ret = false;
+			continue;
+		}
+
+		TuningSet set;
+		snprintf(set.name, sizeof(set.name), "%s", tokens[0]);
+		set.tuning.flipper_torque = strtof(tokens[1], NULL);
+		set.tuning.bumper_restitution = strtof(tokens[2], NULL);
+		set.tuning.spring_force = strtof(tokens[3], NULL);
+		set.tuning.extra_life_score = atoi(tokens[4]);
+		sets.push_back(set);
+	}
+
+	fclose(file);
+
+	return ret && !sets.empty();
+}
+
+// Box2D fills its contact function table on the first contact ever made, done here before the threads can race on it
+static void PrepareBox2D()
+{
+	b2World world(b2Vec2(0.0f, 0.0f));
+	b2CircleShape shape;
+	shape.m_radius = 1.0f;
+
+	b2BodyDef def;
+	world.CreateBody(&def)->CreateFixture(&shape, 0.0f);
+	def.type = b2_dynamicBody;
+	world.CreateBody(&def)->CreateFixture(&shape, 1.0f);
+
+	world.Step(PHYSICS_TIMESTEP, 1, 1);
+}
+
+static GameResult PlayGame(const TableTuning& tuning, const char* script, uint seed)
+{
+	GameResult result = {};
+
+	char frames_arg[16];
+	sprintf_s(frames_arg, "%u", SIMULATION_MAX_TICKS);
+
+	char* args[] = { (char*)"Pinball", (char*)"-headless", (char*)"-frames", frames_arg };
+	Application* App = new Application(sizeof(args) / sizeof(args[0]), args);
+	App->tuning = tuning;
+	App->quiet = true;
+
+	bool ret = App->Init();
+
+	if (ret && script != NULL)
+	{
+		ret = App->input->LoadScript(script, std::mt19937(seed)() % SIMULATION_SCRIPT_PHASES);
+	}
+	else if (ret)
+	{
+		App->input->StartDriving();
+	}
+
+	if (ret)
+	{
+		FlipperPolicy policy(App, seed);
+		ModuleGame* game = App->scene_intro;
+
+		// Game over is the first tick out of INGAME, the score is reset on the one after
+		update_status status = UPDATE_CONTINUE;
+		while (status == UPDATE_CONTINUE && game->state == ModuleGame::State::INGAME)
+		{
+			if (script == NULL) policy.Tick();
+			status = App->Update();
+		}
+
+		result.played = status != UPDATE_ERROR;
+		result.finished = game->state != ModuleGame::State::INGAME;
+		result.score = game->player.actualScore;
+		result.ticks = game->gameTicks;
+		result.drains = game->drainedBalls;
+		result.ball_life_ticks = game->ballLifeTicks;
+	}
+
+	App->CleanUp();
+	delete App;
+
+	return result;
+}
+
+bool SimulateTable(uint games, const char* sweep, const char* script)
+{
+	std::vector<TuningSet> sets;
+
+	if (sweep != NULL)
+	{
+		if (LoadSweep(sweep, sets) == false) return false;
+	}
+	else
+	{
+		sets.push_back(TuningSet{ "default", TableTuning() });
+	}
+
+	PrepareBox2D();
+
+	// Workers take the next game until there are none left, game i plays set i / games with seed i
+	std::vector<GameResult> results(sets.size() * games);
+	std::atomic<uint> next(0);
+
+	uint thread_count = MAX(1u, std::thread::hardware_concurrency());
+	Timer timer;
+
+	std::vector<std::thread> workers;
+	for (uint i = 0; i < thread_count; ++i)
+	{
+		workers.emplace_back([&]()
+		{
+			for (uint game = next++; game < results.size(); game = next++)
+			{
+				results[game] = PlayGame(sets[game / games].tuning, script, game);
+			}
+		});
+	}
+
+	for (std::thread& worker : workers) worker.join();
+
+	double seconds = timer.ReadSec();
+	printf("Simulated %u games in %.1f s on %u threads (%.0f games/min)\n\n", (uint)results.size(), seconds, thread_count, (seconds > 0.0) ? results.size() * 60.0 / seconds : 0.0);
+
+	printf("%-16s %6s %8s %6s %6s %6s %6s %11s %12s %10s\n", "set", "games", "mean", "p10", "p50", "p90", "max", "drains/min", "ball life s", "unfinished");
+
+	bool ret = true;
+
+	for (uint set = 0; set < sets.size(); ++set)
+	{
+		std::vector<int> scores;
+		uint64 ticks = 0, ball_life_ticks = 0;
+		uint drains = 0, unfinished = 0;
+
+		for (uint game = set * games; game < (set + 1) * games; ++game)
+		{
+			const GameResult& result = results[game];
+			if (!result.played)
+			{
+				ret = false;
+				continue;
+			}
+
+			scores.push_back(result.score);
+			ticks += result.ticks;
+			drains += result.drains;
+			ball_life_ticks += result.ball_life_ticks;
+			if (!result.finished) unfinished++;
+		}
+
+		if (scores.empty()) continue;
+
+		std::sort(scores.begin(), scores.end());
+
+		double total = 0.0;
+		for (int score : scores) total += score;
+
+		auto percentile = [&](uint p) { return scores[((scores.size() - 1) * p) / 100]; };
+
+		double minutes = ticks * PHYSICS_TIMESTEP / 60.0;
+		printf("%-16s %6u %8.0f %6d %6d %6d %6d %11.2f %12.1f %10u\n", sets[set].name, (uint)scores.size(), total / scores.size(),
+			percentile(10), percentile(50), percentile(90), scores.back(),
+			(minutes > 0.0) ? drains / minutes : 0.0, (drains > 0) ? ball_life_ticks * PHYSICS_TIMESTEP / drains : 0.0, unfinished);
+	}
+
+	return ret;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Globals.h"
+
+#define SIMULATION_MAX_TICKS (60 * 60 * 10) // Games still going after ten minutes of table time are stopped where they are
+#define SIMULATION_SCRIPT_PHASES 3600 // Scripted games start at a random frame of their first minute
+
+// Plays games headless on every core, each one in its own Application and world, nothing is shared between threads
+// Games per tuning set of the sweep file, or of the shipped tuning without one
+// The input script plays the flippers when given, a heuristic that flips at falling balls otherwise
+// Prints the score distribution, drains per minute and average ball lifetime of each set
+bool SimulateTable(uint games, const char* sweep, const char* script);
\ No newline at end of file
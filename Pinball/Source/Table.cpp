@@ -0,0 +1,242 @@
+#include "Table.h"
+#include "ModulePhysics.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+// Section entries of type T, or NULL if they do not fit in the file
+template <class T>
+static const T* GetSection(const uchar* base, size_t size, const TableSection& section)
+{
+	if (section.offset % 4 != 0 || section.offset > size || section.count > (size - section.offset) / sizeof(T)) return NULL;
+
+	return reinterpret_cast<const T*>(base + section.offset);
+}
+
+bool Table::Load(const char* path)
+{
+	Unload();
+
+	if (file.Open(path) == false)
+	{
+		LOG("Cannot open table: %s", path);
+		return false;
+	}
+
+	const uchar* base = (const uchar*)file.GetData();
+	size_t size = file.GetSize();
+
+	header = (size >= sizeof(TableHeader)) ? reinterpret_cast<const TableHeader*>(base) : NULL;
+
+	if (header == NULL || header->magic != TABLE_MAGIC || header->version != TABLE_VERSION || header->size != size)
+	{
+		LOG("Not a version %d table: %s", TABLE_VERSION, path);
+		Unload();
+		return false;
+	}
+
+	chains = GetSection<TableChain>(base, size, header->chains);
+	vertices = GetSection<TableVertex>(base, size, header->vertices);
+	sensors = GetSection<TableSensor>(base, size, header->sensors);
+	bumpers = GetSection<TableBumper>(base, size, header->bumpers);
+	spawns = GetSection<TableSpawn>(base, size, header->spawns);
+
+	bool valid = chains != NULL && vertices != NULL && sensors != NULL && bumpers != NULL && spawns != NULL && header->texture[TABLE_PATH_SIZE - 1] == '\0';
+
+	for (uint i = 0; valid && i < header->chains.count; ++i)
+	{
+		valid = chains[i].vertex_count >= 3 && chains[i].first_vertex <= header->vertices.count && chains[i].vertex_count <= header->vertices.count - chains[i].first_vertex;
+	}
+
+	if (!valid)
+	{
+		LOG("Corrupt table: %s", path);
+		Unload();
+		return false;
+	}
+
+	LOG("Mapped table %s: %u chains, %u sensors, %u bumpers", path, header->chains.count, header->sensors.count, header->bumpers.count);
+	return true;
+}
+
+void Table::Unload()
+{
+	file.Close();
+
+	header = NULL;
+	chains = NULL;
+	vertices = NULL;
+	sensors = NULL;
+	bumpers = NULL;
+	spawns = NULL;
+}
+
+const TableChain* Table::FindChain(TableChainKind kind) const
+{
+	for (uint i = 0; i < header->chains.count; ++i)
+	{
+		if (chains[i].kind == (uint32)kind) return &chains[i];
+	}
+
+	return NULL;
+}
+
+void Table::GetSpawn(const char* name, int& x, int& y) const
+{
+	for (uint i = 0; i < header->spawns.count; ++i)
+	{
+		if (strncmp(spawns[i].name, name, TABLE_NAME_SIZE) == 0)
+		{
+			x = spawns[i].x;
+			y = spawns[i].y;
+			return;
+		}
+	}
+
+	LOG("Table has no spawn point: %s", name);
+	x = y = 0;
+}
+
+bool Table::Bake(const char* source, const char* destination)
+{
+	TableSource table;
+	return Parse(source, table) && Write(destination, table);
+}
+
+bool Table::Parse(const char* source, TableSource& table)
+{
+	FILE* file = NULL;
+
+	if (fopen_s(&file, source, "r") != 0 || file == NULL)
+	{
+		LOG("Cannot open table source: %s", source);
+		return false;
+	}
+
+	table = TableSource();
+	table.header.magic = TABLE_MAGIC;
+	table.header.version = TABLE_VERSION;
+
+	std::vector<TableChain>& chains = table.chains;
+	std::vector<TableVertex>& vertices = table.vertices;
+
+	// Coordinates are pixels, times the scale for tables traced on the half size image
+	int scale = 1;
+	bool ret = true;
+
+	char line[256];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		char tokens[6][TABLE_PATH_SIZE];
+
+		const char* cursor = line;
+		int read = 0;
+		while (read < 6 && ReadToken(cursor, tokens[read], TABLE_PATH_SIZE)) read++;
+
+		if (read == 0 || tokens[0][0] == '#') continue;
+
+		int values[6] = {};
+		for (int i = 0; i < read; ++i) values[i] = atoi(tokens[i]) * scale;
+
+		if ((tokens[0][0] >= '0' && tokens[0][0] <= '9') && read == 2 && !chains.empty())
+		{
+			vertices.push_back(TableVertex{ PIXEL_TO_METERS(values[0]), PIXEL_TO_METERS(values[1]) });
+			chains.back().vertex_count++;
+		}
+		else if (strcmp(tokens[0], "chain") == 0 && read == 3)
+		{
+			uint32 kind = (strcmp(tokens[1], "board") == 0) ? TABLE_CHAIN_BOARD : (strcmp(tokens[1], "blocker") == 0) ? TABLE_CHAIN_BLOCKER : TABLE_CHAIN_OBSTACLE;
+			chains.push_back(TableChain{ kind, atoi(tokens[2]), (uint32)vertices.size(), 0 });
+		}
+		else if (strcmp(tokens[0], "sensor") == 0 && read == 6)
+		{
+			table.sensors.push_back(TableSensor{ values[2], values[3], values[4], values[5], atoi(tokens[1]) });
+		}
+		else if (strcmp(tokens[0], "bumper") == 0 && read == 5)
+		{
+			table.bumpers.push_back(TableBumper{ values[2], values[3], values[4], atoi(tokens[1]) });
+		}
+		else if (strcmp(tokens[0], "spawn") == 0 && read == 4)
+		{
+			// Names and paths are stored in fixed size fields of the file, longer ones are refused
+			TableSpawn spawn = {};
+			if (snprintf(spawn.name, sizeof(spawn.name), "%s", tokens[1]) >= (int)sizeof(spawn.name))
+			{
+				LOG("Spawn name too long: %s", line);
+				ret = false;
+			}
+			spawn.x = values[2];
+			spawn.y = values[3];
+			table.spawns.push_back(spawn);
+		}
+		else if (strcmp(tokens[0], "texture") == 0 && read == 2)
+		{
+			if (snprintf(table.header.texture, sizeof(table.header.texture), "%s", tokens[1]) >= (int)sizeof(table.header.texture))
+			{
+				LOG("Texture path too long: %s", line);
+				ret = false;
+			}
+		}
+		else if (strcmp(tokens[0], "scale") == 0 && read == 2)
+		{
+			scale = atoi(tokens[1]);
+		}
+		else
+		{
+			LOG("Bad table line: %s", line);
+			ret = false;
+		}
+	}
+
+	fclose(file);
+
+	for (const TableChain& chain : chains)
+	{
+		if (chain.vertex_count < 3)
+		{
+			LOG("Table chain with less than 3 vertices in %s", source);
+			ret = false;
+		}
+	}
+
+	return ret;
+}
+
+bool Table::Write(const char* destination, const TableSource& table)
+{
+	// Sections follow the header in declaration order
+	TableHeader header = table.header;
+	uint32 offset = sizeof(TableHeader);
+	header.chains = TableSection{ offset, (uint32)table.chains.size() };
+	offset += (uint32)(table.chains.size() * sizeof(TableChain));
+	header.vertices = TableSection{ offset, (uint32)table.vertices.size() };
+	offset += (uint32)(table.vertices.size() * sizeof(TableVertex));
+	header.sensors = TableSection{ offset, (uint32)table.sensors.size() };
+	offset += (uint32)(table.sensors.size() * sizeof(TableSensor));
+	header.bumpers = TableSection{ offset, (uint32)table.bumpers.size() };
+	offset += (uint32)(table.bumpers.size() * sizeof(TableBumper));
+	header.spawns = TableSection{ offset, (uint32)table.spawns.size() };
+	offset += (uint32)(table.spawns.size() * sizeof(TableSpawn));
+	header.size = offset;
+
+	FILE* file = NULL;
+
+	if (fopen_s(&file, destination, "wb") != 0 || file == NULL)
+	{
+		LOG("Cannot write table: %s", destination);
+		return false;
+	}
+
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(table.chains.data(), sizeof(TableChain), table.chains.size(), file);
+	fwrite(table.vertices.data(), sizeof(TableVertex), table.vertices.size(), file);
+	fwrite(table.sensors.data(), sizeof(TableSensor), table.sensors.size(), file);
+	fwrite(table.bumpers.data(), sizeof(TableBumper), table.bumpers.size(), file);
+	fwrite(table.spawns.data(), sizeof(TableSpawn), table.spawns.size(), file);
+	fclose(file);
+
+	printf("Baked %s: %u chains, %u vertices, %u sensors, %u bumpers, %u spawns, %u bytes\n", destination,
+		(uint)table.chains.size(), (uint)table.vertices.size(), (uint)table.sensors.size(), (uint)table.bumpers.size(), (uint)table.spawns.size(), header.size);
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Globals.h"
+#include "MappedFile.h"
+
+#include <vector>
+
+#define TABLE_MAGIC 0x4C424154 // "TABL"
+#define TABLE_VERSION 1
+#define TABLE_PATH_SIZE 64
+#define TABLE_NAME_SIZE 16
+#define TABLE_PLAIN_WALL 1 // Interaction of walls that only bounce the ball, -trace-table replaces these
+
+// Which entity builds the chain
+enum TableChainKind
+{
+	TABLE_CHAIN_BOARD,
+	TABLE_CHAIN_BLOCKER,	// Closes the launch lane once the ball is in play
+	TABLE_CHAIN_OBSTACLE
+};
+
+struct TableSection
+{
+	uint32 offset;	// From the start of the file
+	uint32 count;
+};
+
+// Everything is 4 byte fields, the file is used straight from the mapping
+struct TableHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint32 size;
+	char texture[TABLE_PATH_SIZE];	// Board image, drawn at twice its size
+	TableSection chains;
+	TableSection vertices;
+	TableSection sensors;
+	TableSection bumpers;
+	TableSection spawns;
+};
+
+struct TableChain
+{
+	uint32 kind;
+	int interaction;
+	uint32 first_vertex;
+	uint32 vertex_count;
+};
+
+// Already in meters
+struct TableVertex
+{
+	float x, y;
+};
+
+// Pixels, centred on x, y
+struct TableSensor
+{
+	int x, y;
+	int width, height;
+	int interaction;
+};
+
+struct TableBumper
+{
+	int x, y;
+	int radius;
+	int interaction;
+};
+
+// Where the game places an entity, in pixels
+struct TableSpawn
+{
+	char name[TABLE_NAME_SIZE];
+	int x, y;
+};
+
+// A table being built by the tools, in the same layout it is written with
+struct TableSource
+{
+	TableHeader header;
+	std::vector<TableChain> chains;
+	std::vector<TableVertex> vertices;
+	std::vector<TableSensor> sensors;
+	std::vector<TableBumper> bumpers;
+	std::vector<TableSpawn> spawns;
+};
+
+// Table geometry baked by -bake-table, see Assets/Ruby/ruby_table.txt for the source format
+// Loading only maps the file and checks the header, loading another table is just another mapping
+class Table
+{
+public:
+
+	bool Load(const char* path);
+	void Unload();
+
+	// Text source to a binary table
+	static bool Bake(const char* source, const char* destination);
+	static bool Parse(const char* source, TableSource& table);
+	static bool Write(const char* destination, const TableSource& table);
+
+	const char* GetTexture() const { return header->texture; }
+
+	uint GetChainCount() const { return header->chains.count; }
+	const TableChain& GetChain(uint index) const { return chains[index]; }
+	const TableVertex* GetVertices(const TableChain& chain) const { return vertices + chain.first_vertex; }
+	const TableChain* FindChain(TableChainKind kind) const;
+
+	uint GetSensorCount() const { return header->sensors.count; }
+	const TableSensor& GetSensor(uint index) const { return sensors[index]; }
+
+	uint GetBumperCount() const { return header->bumpers.count; }
+	const TableBumper& GetBumper(uint index) const { return bumpers[index]; }
+
+	// Logs and returns 0, 0 if the table has no spawn with that name
+	void GetSpawn(const char* name, int& x, int& y) const;
+
+private:
+
+	MappedFile file;
+
+	const TableHeader* header = NULL;
+	const TableChain* chains = NULL;
+	const TableVertex* vertices = NULL;
+	const TableSensor* sensors = NULL;
+	const TableBumper* bumpers = NULL;
+	const TableSpawn* spawns = NULL;
+};
\ No newline at end of file
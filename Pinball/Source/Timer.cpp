@@ -4,7 +4,13 @@
 
 #include "Timer.h"
 
-#include "raylib.h"
+#include <chrono>
+
+// NOTE: Uses a steady clock instead of raylib GetTime(), which needs a window to be created
+static double NowSec()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 Timer::Timer()
 {
@@ -13,10 +19,10 @@ Timer::Timer()
 
 void Timer::Start()
 {
-	started_at = GetTime();
+	started_at = NowSec();
 }
 
 double Timer::ReadSec() const
 {
-	return (GetTime() - started_at);
+	return (NowSec() - started_at);
 }
\ No newline at end of file
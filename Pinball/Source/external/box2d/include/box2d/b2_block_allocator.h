@@ -26,7 +26,7 @@
 #include "b2_api.h"
 #include "b2_settings.h"
 
-const int32 b2_blockSizeCount = 14;
+const int32 b2_blockSizeCount = 16;
 
 struct b2Block;
 struct b2Chunk;
@@ -48,6 +48,10 @@ public:
 
 	void Clear();
 
+	/// Number of chunks taken from b2Alloc so far. Freed blocks are recycled, so this stops
+	/// growing once the world has reached its largest number of objects.
+	int32 GetChunkCount() const { return m_chunkCount; }
+
 private:
 
 	b2Chunk* m_chunks;
@@ -450,6 +450,7 @@ private:
 	b2World* m_world;
 	b2Body* m_prev;
 	b2Body* m_next;
+	int32 m_worldIndex;
 
 	b2Fixture* m_fixtureList;
 	int32 m_fixtureCount;
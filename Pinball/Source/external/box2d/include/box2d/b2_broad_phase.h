@@ -27,6 +27,7 @@
 #include "b2_settings.h"
 #include "b2_collision.h"
 #include "b2_dynamic_tree.h"
+#include "b2_static_tree.h"
 
 struct B2_API b2Pair
 {
@@ -34,16 +35,21 @@ struct B2_API b2Pair
 	int32 proxyIdB;
 };
 
+template <typename T> struct b2TreeCallback;
+
 /// The broad-phase is used for computing pairs and performing volume queries and ray casts.
 /// This broad-phase does not persist pairs. Instead, this reports potentially new pairs.
 /// It is up to the client to consume the new pairs and to track subsequent overlap.
+/// Proxies that never move go in a static tree, built once before the next pairs are found,
+/// and are only paired with the proxies of the dynamic tree.
 class B2_API b2BroadPhase
 {
 public:
 
 	enum
 	{
-		e_nullProxy = -1
+		e_nullProxy = -1,
+		e_staticProxy = 0x40000000	///< Ids of static proxies start here
 	};
 
 	b2BroadPhase();
@@ -53,6 +59,13 @@ public:
 	/// UpdatePairs is called.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create a proxy in the static tree. Two static proxies are never paired, so only use it
+	/// for proxies of static bodies.
+	int32 CreateStaticProxy(const b2AABB& aabb, void* userData);
+
+	/// Is the proxy in the static tree.
+	static bool IsStaticProxy(int32 proxyId) { return proxyId >= e_staticProxy; }
+
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
 
@@ -103,6 +116,9 @@ public:
 	/// Get the quality metric of the embedded tree.
 	float GetTreeQuality() const;
 
+	/// Get the tree of the static proxies.
+	const b2StaticTree& GetStaticTree() const;
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
@@ -111,6 +127,7 @@ public:
 private:
 
 	friend class b2DynamicTree;
+	template <typename T> friend struct b2TreeCallback;
 
 	void BufferMove(int32 proxyId);
 	void UnBufferMove(int32 proxyId);
@@ -118,6 +135,7 @@ private:
 	bool QueryCallback(int32 proxyId);
 
 	b2DynamicTree m_tree;
+	b2StaticTree m_staticTree;
 
 	int32 m_proxyCount;
 
@@ -132,20 +150,50 @@ private:
 	int32 m_queryProxyId;
 };
 
+// Hands tree ids to a client callback as broad-phase ids, and remembers if it asked to stop
+template <typename T>
+struct b2TreeCallback
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		proceed = callback->QueryCallback(offset + proxyId);
+		return proceed;
+	}
+
+	float RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		return callback->RayCastCallback(input, offset + proxyId);
+	}
+
+	T* callback;
+	int32 offset;
+	bool proceed;
+};
+
 inline void* b2BroadPhase::GetUserData(int32 proxyId) const
 {
+	if (IsStaticProxy(proxyId))
+	{
+		return m_staticTree.GetUserData(proxyId - e_staticProxy);
+	}
+
 	return m_tree.GetUserData(proxyId);
 }
 
 inline bool b2BroadPhase::TestOverlap(int32 proxyIdA, int32 proxyIdB) const
 {
-	const b2AABB& aabbA = m_tree.GetFatAABB(proxyIdA);
-	const b2AABB& aabbB = m_tree.GetFatAABB(proxyIdB);
+	const b2AABB& aabbA = GetFatAABB(proxyIdA);
+	const b2AABB& aabbB = GetFatAABB(proxyIdB);
 	return b2TestOverlap(aabbA, aabbB);
 }
 
 inline const b2AABB& b2BroadPhase::GetFatAABB(int32 proxyId) const
 {
+	if (IsStaticProxy(proxyId))
+	{
+		return m_staticTree.GetAABB(proxyId - e_staticProxy);
+	}
+
 	return m_tree.GetFatAABB(proxyId);
 }
 
@@ -169,12 +217,25 @@ inline float b2BroadPhase::GetTreeQuality() const
 	return m_tree.GetAreaRatio();
 }
 
+inline const b2StaticTree& b2BroadPhase::GetStaticTree() const
+{
+	return m_staticTree;
+}
+
 template <typename T>
 void b2BroadPhase::UpdatePairs(T* callback)
 {
 	// Reset pair buffer
 	m_pairCount = 0;
 
+	// Only rebuilt if static proxies changed, once after the level is loaded in practice
+	m_staticTree.Build();
+
+	b2TreeCallback<b2BroadPhase> staticCallback;
+	staticCallback.callback = this;
+	staticCallback.offset = e_staticProxy;
+	staticCallback.proceed = true;
+
 	// Perform tree queries for all moving proxies.
 	for (int32 i = 0; i < m_moveCount; ++i)
 	{
@@ -186,18 +247,24 @@ void b2BroadPhase::UpdatePairs(T* callback)
 
 		// We have to query the tree with the fat AABB so that
 		// we don't fail to create a pair that may touch later.
-		const b2AABB& fatAABB = m_tree.GetFatAABB(m_queryProxyId);
+		const b2AABB& fatAABB = GetFatAABB(m_queryProxyId);
 
 		// Query tree, create pairs and add them pair buffer.
 		m_tree.Query(this, fatAABB);
+
+		// Static proxies only pair with dynamic ones
+		if (IsStaticProxy(m_queryProxyId) == false)
+		{
+			m_staticTree.Query(&staticCallback, fatAABB);
+		}
 	}
 
 	// Send pairs to caller
 	for (int32 i = 0; i < m_pairCount; ++i)
 	{
 		b2Pair* primaryPair = m_pairBuffer + i;
-		void* userDataA = m_tree.GetUserData(primaryPair->proxyIdA);
-		void* userDataB = m_tree.GetUserData(primaryPair->proxyIdB);
+		void* userDataA = GetUserData(primaryPair->proxyIdA);
+		void* userDataB = GetUserData(primaryPair->proxyIdB);
 
 		callback->AddPair(userDataA, userDataB);
 	}
@@ -211,7 +278,14 @@ void b2BroadPhase::UpdatePairs(T* callback)
 			continue;
 		}
 
-		m_tree.ClearMoved(proxyId);
+		if (IsStaticProxy(proxyId))
+		{
+			m_staticTree.ClearMoved(proxyId - e_staticProxy);
+		}
+		else
+		{
+			m_tree.ClearMoved(proxyId);
+		}
 	}
 
 	// Reset move buffer
@@ -221,18 +295,40 @@ void b2BroadPhase::UpdatePairs(T* callback)
 template <typename T>
 inline void b2BroadPhase::Query(T* callback, const b2AABB& aabb) const
 {
-	m_tree.Query(callback, aabb);
+	b2TreeCallback<T> treeCallback;
+	treeCallback.callback = callback;
+	treeCallback.offset = e_staticProxy;
+	treeCallback.proceed = true;
+	m_staticTree.Query(&treeCallback, aabb);
+
+	if (treeCallback.proceed)
+	{
+		treeCallback.offset = 0;
+		m_tree.Query(&treeCallback, aabb);
+	}
 }
 
 template <typename T>
 inline void b2BroadPhase::RayCast(T* callback, const b2RayCastInput& input) const
 {
-	m_tree.RayCast(callback, input);
+	b2TreeCallback<T> staticCallback;
+	staticCallback.callback = callback;
+	staticCallback.offset = e_staticProxy;
+	staticCallback.proceed = true;
+
+	// The dynamic tree goes on from where the walls clipped the ray
+	b2RayCastInput subInput = input;
+	subInput.maxFraction = m_staticTree.RayCast(&staticCallback, input);
+	if (subInput.maxFraction > 0.0f)
+	{
+		m_tree.RayCast(callback, subInput);
+	}
 }
 
 inline void b2BroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	m_tree.ShiftOrigin(newOrigin);
+	m_staticTree.ShiftOrigin(newOrigin);
 }
 
 #endif
@@ -218,6 +218,7 @@ protected:
 	// World pool and list pointers.
 	b2Contact* m_prev;
 	b2Contact* m_next;
+	int32 m_managerIndex;
 
 	// Nodes for connecting bodies.
 	b2ContactEdge m_nodeA;
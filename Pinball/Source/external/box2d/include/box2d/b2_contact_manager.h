@@ -36,6 +36,7 @@ class B2_API b2ContactManager
 {
 public:
 	b2ContactManager();
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -49,6 +50,10 @@ public:
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
 	int32 m_contactCount;
+
+	// Every contact once more, m_contactArray[c->m_managerIndex] == c. Collide() walks this one
+	b2Contact** m_contactArray;
+	int32 m_contactCapacity;
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
@@ -67,15 +67,21 @@ struct B2_API b2BodyUserData
 };
 
 /// You can define this to inject whatever data you want in b2Fixture
+/// The game keeps what a contact reports and how wide the wall is, in the 8 bytes the legacy
+/// pointer took so a 64-bit b2Fixture still fits the 80 byte block.
 struct B2_API b2FixtureUserData
 {
 	b2FixtureUserData()
 	{
-		pointer = 0;
+		interaction = 0;
+		thickness = 0.0f;
 	}
 
-	/// For legacy compatibility
-	uintptr_t pointer;
+	/// Interaction id reported by contacts with the fixture
+	int32 interaction;
+
+	/// Rough width of the wall the fixture makes, in meters
+	float thickness;
 };
 
 /// You can define this to inject whatever data you want in b2Joint
@@ -122,6 +128,10 @@ inline void b2Log(const char* string, ...)
 
 #endif // B2_USER_SETTINGS
 
+/// Number of b2Alloc_Default calls so far, by every world and thread. Stays at zero
+/// with user settings, as your own b2Alloc does not count.
+B2_API int32 b2GetAllocCount();
+
 #include "b2_common.h"
 
 #endif
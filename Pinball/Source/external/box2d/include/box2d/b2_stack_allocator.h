@@ -50,6 +50,9 @@ public:
 
 	int32 GetMaxAllocation() const;
 
+	/// Number of allocations that did not fit in the stack and went to b2Alloc.
+	int32 GetHeapCount() const;
+
 private:
 
 	char m_data[b2_stackSize];
@@ -57,6 +60,7 @@ private:
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
+	int32 m_heapCount;
 
 	b2StackEntry m_entries[b2_maxStackEntries];
 	int32 m_entryCount;
@@ -0,0 +1,321 @@
+#ifndef B2_STATIC_TREE_H
+#define B2_STATIC_TREE_H
+
+#include "b2_api.h"
+#include "b2_collision.h"
+#include "b2_growable_stack.h"
+
+/// A proxy of the static tree. The client does not interact with this directly.
+struct B2_API b2StaticProxy
+{
+	/// Tight AABB, static proxies do not move so there is no need to enlarge it
+	b2AABB aabb;
+
+	void* userData;
+
+	// Next free proxy, only while unused
+	int32 next;
+
+	bool used;
+	bool moved;
+};
+
+/// A node of the static tree. Inner nodes are followed by their first child, index is the second one.
+/// Leaves have a count and index is their first entry in the leaf array.
+struct B2_API b2StaticNode
+{
+	b2AABB aabb;
+	int32 index;
+	int32 count;
+};
+
+/// A proxy AABB copied in tree order, so a leaf reads its proxies from one run of memory.
+struct B2_API b2StaticLeaf
+{
+	b2AABB aabb;
+	int32 proxyId;
+};
+
+/// A read only AABB tree for proxies that never move, like the walls of a level.
+/// It is built from scratch with the surface area heuristic instead of updated one proxy at a
+/// time, into a flat array in depth first order. Creating, destroying or moving a proxy marks it
+/// out of date; queries then check every proxy until Build is called again.
+class B2_API b2StaticTree
+{
+public:
+	b2StaticTree();
+	~b2StaticTree();
+
+	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
+	int32 CreateProxy(const b2AABB& aabb, void* userData);
+
+	/// Destroy a proxy. This asserts if the id is invalid.
+	void DestroyProxy(int32 proxyId);
+
+	/// Give a proxy a new AABB. Static geometry is not expected to move, this is only for teleports.
+	void MoveProxy(int32 proxyId, const b2AABB& aabb);
+
+	/// Get proxy user data.
+	void* GetUserData(int32 proxyId) const;
+
+	bool WasMoved(int32 proxyId) const;
+	void ClearMoved(int32 proxyId);
+
+	/// Get the AABB for a proxy.
+	const b2AABB& GetAABB(int32 proxyId) const;
+
+	/// Rebuild the nodes if proxies changed since the last build.
+	void Build();
+
+	/// Query an AABB for overlapping proxies. The callback class
+	/// is called for each proxy that overlaps the supplied AABB.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	/// Ray-cast against the proxies in the tree, see b2DynamicTree::RayCast.
+	/// @return the fraction the ray was clipped to, 0 if the client terminated the ray cast.
+	template <typename T>
+	float RayCast(T* callback, const b2RayCastInput& input) const;
+
+	/// Number of nodes, leaves included.
+	int32 GetNodeCount() const { return m_nodeCount; }
+
+	/// Compute the height of the tree.
+	int32 GetHeight() const;
+
+	/// Shift the world origin. Useful for large worlds.
+	/// The shift formula is: position -= newOrigin
+	/// @param newOrigin the new origin with respect to the old origin
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+private:
+
+	int32 BuildNode(int32 first, int32 count);
+	int32 ComputeHeight(int32 nodeId) const;
+
+	b2StaticProxy* m_proxies;
+	int32 m_proxyCount;
+	int32 m_proxyCapacity;
+	int32 m_freeList;
+
+	b2StaticNode* m_nodes;
+	int32 m_nodeCount;
+
+	b2StaticLeaf* m_leaves;
+	int32 m_leafCount;
+
+	// Proxies changed since the last build
+	bool m_dirty;
+};
+
+inline void* b2StaticTree::GetUserData(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].userData;
+}
+
+inline bool b2StaticTree::WasMoved(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].moved;
+}
+
+inline void b2StaticTree::ClearMoved(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	m_proxies[proxyId].moved = false;
+}
+
+inline const b2AABB& b2StaticTree::GetAABB(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].aabb;
+}
+
+template <typename T>
+inline void b2StaticTree::Query(T* callback, const b2AABB& aabb) const
+{
+	if (m_dirty)
+	{
+		for (int32 i = 0; i < m_proxyCapacity; ++i)
+		{
+			if (m_proxies[i].used && b2TestOverlap(m_proxies[i].aabb, aabb))
+			{
+				bool proceed = callback->QueryCallback(i);
+				if (proceed == false)
+				{
+					return;
+				}
+			}
+		}
+		return;
+	}
+
+	if (m_nodeCount == 0)
+	{
+		return;
+	}
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(0);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeId = stack.Pop();
+		const b2StaticNode* node = m_nodes + nodeId;
+
+		if (b2TestOverlap(node->aabb, aabb) == false)
+		{
+			continue;
+		}
+
+		if (node->count > 0)
+		{
+			const b2StaticLeaf* leaf = m_leaves + node->index;
+			for (int32 i = 0; i < node->count; ++i)
+			{
+				if (b2TestOverlap(leaf[i].aabb, aabb))
+				{
+					bool proceed = callback->QueryCallback(leaf[i].proxyId);
+					if (proceed == false)
+					{
+						return;
+					}
+				}
+			}
+		}
+		else
+		{
+			stack.Push(node->index);
+			stack.Push(nodeId + 1);
+		}
+	}
+}
+
+template <typename T>
+inline float b2StaticTree::RayCast(T* callback, const b2RayCastInput& input) const
+{
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 r = p2 - p1;
+	b2Assert(r.LengthSquared() > 0.0f);
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float maxFraction = input.maxFraction;
+
+	// Build a bounding box for the segment.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * (p2 - p1);
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+	}
+
+	// Out of date trees are ray cast as a single leaf holding every proxy
+	const b2StaticNode* nodes = m_nodes;
+	b2StaticNode all;
+	if (m_dirty)
+	{
+		all.aabb = segmentAABB;
+		all.index = 0;
+		all.count = m_proxyCapacity;
+		nodes = &all;
+	}
+	else if (m_nodeCount == 0)
+	{
+		return maxFraction;
+	}
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(0);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeId = stack.Pop();
+		const b2StaticNode* node = nodes + nodeId;
+
+		if (b2TestOverlap(node->aabb, segmentAABB) == false)
+		{
+			continue;
+		}
+
+		if (node->count == 0)
+		{
+			// Separating axis for segment (Gino, p80).
+			// |dot(v, p1 - c)| > dot(|v|, h)
+			b2Vec2 c = node->aabb.GetCenter();
+			b2Vec2 h = node->aabb.GetExtents();
+			float separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+			if (separation <= 0.0f)
+			{
+				stack.Push(node->index);
+				stack.Push(nodeId + 1);
+			}
+			continue;
+		}
+
+		for (int32 i = 0; i < node->count; ++i)
+		{
+			int32 proxyId;
+			b2AABB aabb;
+			if (m_dirty)
+			{
+				if (m_proxies[node->index + i].used == false)
+				{
+					continue;
+				}
+
+				proxyId = node->index + i;
+				aabb = m_proxies[proxyId].aabb;
+			}
+			else
+			{
+				proxyId = m_leaves[node->index + i].proxyId;
+				aabb = m_leaves[node->index + i].aabb;
+			}
+
+			if (b2TestOverlap(aabb, segmentAABB) == false)
+			{
+				continue;
+			}
+
+			b2Vec2 c = aabb.GetCenter();
+			b2Vec2 h = aabb.GetExtents();
+			float separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+			if (separation > 0.0f)
+			{
+				continue;
+			}
+
+			b2RayCastInput subInput;
+			subInput.p1 = input.p1;
+			subInput.p2 = input.p2;
+			subInput.maxFraction = maxFraction;
+
+			float value = callback->RayCastCallback(subInput, proxyId);
+
+			if (value == 0.0f)
+			{
+				// The client has terminated the ray cast.
+				return 0.0f;
+			}
+
+			if (value > 0.0f)
+			{
+				// Update segment bounding box.
+				maxFraction = value;
+				b2Vec2 t = p1 + maxFraction * (p2 - p1);
+				segmentAABB.lowerBound = b2Min(p1, t);
+				segmentAABB.upperBound = b2Max(p1, t);
+			}
+		}
+	}
+
+	return maxFraction;
+}
+
+#endif
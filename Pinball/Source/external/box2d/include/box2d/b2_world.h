@@ -39,6 +39,16 @@ class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+class b2ThreadPool;
+
+/// Memory use of a world, to check that steps stop going to the heap once it has warmed up.
+struct B2_API b2AllocatorStats
+{
+	int32 stepAllocations;		///< b2Alloc calls during the last step, listener callbacks and other threads included
+	int32 blockChunks;			///< chunks the block allocator has taken, bodies, fixtures and contacts live there
+	int32 stackPeak;			///< largest per step allocation in bytes, the largest of all workers
+	int32 stackHeapAllocations;	///< per step allocations that did not fit in a stack allocator
+};
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -146,6 +156,12 @@ public:
 	b2Contact* GetContactList();
 	const b2Contact* GetContactList() const;
 
+	/// The same bodies and contacts in dense arrays of GetBodyCount() and GetContactCount() entries.
+	/// Faster to walk than the lists, but destroying one moves the last one into its slot, so the
+	/// order is not the list order. Use them for loops that do not depend on the order.
+	b2Body* const* GetBodyArray() const;
+	b2Contact* const* GetContactArray() const;
+
 	/// Enable/disable sleep.
 	void SetAllowSleeping(bool flag);
 	bool GetAllowSleeping() const { return m_allowSleep; }
@@ -162,6 +178,11 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Solve independent islands on this many threads, the calling thread included. The default of 1
+	/// solves them in turn on the calling thread. The result of a step does not depend on the count.
+	void SetWorkerCount(int32 count);
+	int32 GetWorkerCount() const;
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -210,6 +231,9 @@ public:
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Get the allocator counters.
+	b2AllocatorStats GetAllocatorStats() const;
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
@@ -222,6 +246,8 @@ private:
 	friend class b2Controller;
 
 	void Solve(const b2TimeStep& step);
+	void SolveIslands(const b2TimeStep& step);
+	void SolveIslandsParallel(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
@@ -229,11 +255,19 @@ private:
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
+	// Only created with more than one worker, each extra worker has its own stack allocator
+	b2ThreadPool* m_threadPool;
+	b2StackAllocator* m_workerAllocators;
+
 	b2ContactManager m_contactManager;
 
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
 
+	// Every body once more, m_bodyArray[b->m_worldIndex] == b
+	b2Body** m_bodyArray;
+	int32 m_bodyCapacity;
+
 	int32 m_bodyCount;
 	int32 m_jointCount;
 
@@ -259,6 +293,7 @@ private:
 	bool m_stepComplete;
 
 	b2Profile m_profile;
+	int32 m_stepAllocations;
 };
 
 inline b2Body* b2World::GetBodyList()
@@ -291,6 +326,16 @@ inline const b2Contact* b2World::GetContactList() const
 	return m_contactManager.m_contactList;
 }
 
+inline b2Body* const* b2World::GetBodyArray() const
+{
+	return m_bodyArray;
+}
+
+inline b2Contact* const* b2World::GetContactArray() const
+{
+	return m_contactManager.m_contactArray;
+}
+
 inline int32 b2World::GetBodyCount() const
 {
 	return m_bodyCount;
@@ -50,15 +50,38 @@ int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 	return proxyId;
 }
 
+int32 b2BroadPhase::CreateStaticProxy(const b2AABB& aabb, void* userData)
+{
+	int32 proxyId = e_staticProxy + m_staticTree.CreateProxy(aabb, userData);
+	++m_proxyCount;
+	BufferMove(proxyId);
+	return proxyId;
+}
+
 void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
 	UnBufferMove(proxyId);
 	--m_proxyCount;
+
+	if (IsStaticProxy(proxyId))
+	{
+		m_staticTree.DestroyProxy(proxyId - e_staticProxy);
+		return;
+	}
+
 	m_tree.DestroyProxy(proxyId);
 }
 
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
+	if (IsStaticProxy(proxyId))
+	{
+		// Teleported, the static tree is rebuilt before the next pairs are found
+		m_staticTree.MoveProxy(proxyId - e_staticProxy, aabb);
+		BufferMove(proxyId);
+		return;
+	}
+
 	bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
 	if (buffer)
 	{
@@ -97,7 +120,7 @@ void b2BroadPhase::UnBufferMove(int32 proxyId)
 	}
 }
 
-// This is called from b2DynamicTree::Query when we are gathering pairs.
+// This is called from b2DynamicTree::Query and b2StaticTree::Query when we are gathering pairs.
 bool b2BroadPhase::QueryCallback(int32 proxyId)
 {
 	// A proxy cannot form a pair with itself.
@@ -106,7 +129,8 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 		return true;
 	}
 
-	const bool moved = m_tree.WasMoved(proxyId);
+	// Static ids are above every dynamic one, so a moved static proxy always finds the pair itself
+	const bool moved = IsStaticProxy(proxyId) ? m_staticTree.WasMoved(proxyId - e_staticProxy) : m_tree.WasMoved(proxyId);
 	if (moved && proxyId > m_queryProxyId)
 	{
 		// Both proxies are moving. Avoid duplicate pairs.
@@ -0,0 +1,330 @@
+#include "box2d/b2_static_tree.h"
+
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+
+static const int32 b2_nullProxy = -1;
+
+// Split candidates tested per node, along the longest axis of the proxy centers
+static const int32 b2_staticBinCount = 16;
+
+// Nodes with more proxies are always split
+static const int32 b2_staticLeafSize = 4;
+
+// Cost of testing a node against the cost of testing one proxy, both are an AABB overlap test
+static const float b2_staticTraversalCost = 1.0f;
+
+b2StaticTree::b2StaticTree()
+{
+	m_proxyCapacity = 16;
+	m_proxyCount = 0;
+	m_proxies = (b2StaticProxy*)b2Alloc(m_proxyCapacity * sizeof(b2StaticProxy));
+	std::fill(m_proxies, m_proxies + m_proxyCapacity, b2StaticProxy());
+
+	// Build a linked list for the free list.
+	for (int32 i = 0; i < m_proxyCapacity - 1; ++i)
+	{
+		m_proxies[i].next = i + 1;
+	}
+	m_proxies[m_proxyCapacity - 1].next = b2_nullProxy;
+	m_freeList = 0;
+
+	m_nodes = nullptr;
+	m_nodeCount = 0;
+	m_leaves = nullptr;
+	m_leafCount = 0;
+	m_dirty = false;
+}
+
+b2StaticTree::~b2StaticTree()
+{
+	b2Free(m_leaves);
+	b2Free(m_nodes);
+	b2Free(m_proxies);
+}
+
+int32 b2StaticTree::CreateProxy(const b2AABB& aabb, void* userData)
+{
+	if (m_freeList == b2_nullProxy)
+	{
+		b2StaticProxy* oldProxies = m_proxies;
+		m_proxies = (b2StaticProxy*)b2Alloc(2 * m_proxyCapacity * sizeof(b2StaticProxy));
+		memcpy(m_proxies, oldProxies, m_proxyCapacity * sizeof(b2StaticProxy));
+		std::fill(m_proxies + m_proxyCapacity, m_proxies + 2 * m_proxyCapacity, b2StaticProxy());
+		b2Free(oldProxies);
+
+		for (int32 i = m_proxyCapacity; i < 2 * m_proxyCapacity - 1; ++i)
+		{
+			m_proxies[i].next = i + 1;
+		}
+		m_proxies[2 * m_proxyCapacity - 1].next = b2_nullProxy;
+		m_freeList = m_proxyCapacity;
+		m_proxyCapacity *= 2;
+	}
+
+	int32 proxyId = m_freeList;
+	b2StaticProxy* proxy = m_proxies + proxyId;
+	m_freeList = proxy->next;
+
+	proxy->aabb = aabb;
+	proxy->userData = userData;
+	proxy->next = b2_nullProxy;
+	proxy->used = true;
+	proxy->moved = true;
+	++m_proxyCount;
+
+	m_dirty = true;
+	return proxyId;
+}
+
+void b2StaticTree::DestroyProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(m_proxies[proxyId].used);
+
+	b2StaticProxy* proxy = m_proxies + proxyId;
+	proxy->userData = nullptr;
+	proxy->used = false;
+	proxy->moved = false;
+	proxy->next = m_freeList;
+	m_freeList = proxyId;
+	--m_proxyCount;
+
+	m_dirty = true;
+}
+
+void b2StaticTree::MoveProxy(int32 proxyId, const b2AABB& aabb)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(m_proxies[proxyId].used);
+
+	m_proxies[proxyId].aabb = aabb;
+	m_proxies[proxyId].moved = true;
+
+	m_dirty = true;
+}
+
+void b2StaticTree::Build()
+{
+	if (m_dirty == false)
+	{
+		return;
+	}
+
+	b2Free(m_leaves);
+	b2Free(m_nodes);
+	m_leaves = nullptr;
+	m_nodes = nullptr;
+	m_nodeCount = 0;
+	m_leafCount = m_proxyCount;
+	m_dirty = false;
+
+	if (m_leafCount == 0)
+	{
+		return;
+	}
+
+	m_leaves = (b2StaticLeaf*)b2Alloc(m_leafCount * sizeof(b2StaticLeaf));
+	int32 count = 0;
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		if (m_proxies[i].used)
+		{
+			m_leaves[count].aabb = m_proxies[i].aabb;
+			m_leaves[count].proxyId = i;
+			++count;
+		}
+	}
+	b2Assert(count == m_leafCount);
+
+	// Every leaf holds at least one proxy, so a binary tree over them has less than twice as many nodes
+	m_nodes = (b2StaticNode*)b2Alloc((2 * m_leafCount - 1) * sizeof(b2StaticNode));
+	BuildNode(0, m_leafCount);
+}
+
+// Binned surface area heuristic (Wald, On fast Construction of SAH-based Bounding Volume Hierarchies).
+// In 2D the surface area of a box is its perimeter.
+int32 b2StaticTree::BuildNode(int32 first, int32 count)
+{
+	int32 nodeId = m_nodeCount++;
+	b2StaticNode* node = m_nodes + nodeId;
+	b2StaticLeaf* leaves = m_leaves + first;
+
+	b2AABB centers;
+	node->aabb = leaves[0].aabb;
+	centers.lowerBound = centers.upperBound = leaves[0].aabb.GetCenter();
+	for (int32 i = 1; i < count; ++i)
+	{
+		b2Vec2 center = leaves[i].aabb.GetCenter();
+		node->aabb.Combine(leaves[i].aabb);
+		centers.lowerBound = b2Min(centers.lowerBound, center);
+		centers.upperBound = b2Max(centers.upperBound, center);
+	}
+
+	b2Vec2 extents = centers.upperBound - centers.lowerBound;
+	int32 axis = extents.x >= extents.y ? 0 : 1;
+	float lower = centers.lowerBound(axis);
+	float width = extents(axis);
+
+	int32 split = 0;
+	if (count > 1 && width > 0.0f)
+	{
+		int32 binCounts[b2_staticBinCount] = {};
+		b2AABB binAABBs[b2_staticBinCount];
+		float scale = b2_staticBinCount / width;
+
+		for (int32 i = 0; i < count; ++i)
+		{
+			int32 bin = b2Min(int32((leaves[i].aabb.GetCenter()(axis) - lower) * scale), b2_staticBinCount - 1);
+			if (binCounts[bin] == 0)
+			{
+				binAABBs[bin] = leaves[i].aabb;
+			}
+			else
+			{
+				binAABBs[bin].Combine(leaves[i].aabb);
+			}
+			++binCounts[bin];
+		}
+
+		// Sweep from the right for the cost of everything above each split
+		float rightCosts[b2_staticBinCount];
+		int32 rightCount = 0;
+		b2AABB rightAABB = node->aabb;
+		for (int32 bin = b2_staticBinCount - 1; bin > 0; --bin)
+		{
+			if (binCounts[bin] > 0)
+			{
+				if (rightCount == 0)
+				{
+					rightAABB = binAABBs[bin];
+				}
+				else
+				{
+					rightAABB.Combine(binAABBs[bin]);
+				}
+				rightCount += binCounts[bin];
+			}
+			rightCosts[bin] = rightCount > 0 ? rightCount * rightAABB.GetPerimeter() : 0.0f;
+		}
+
+		// Then from the left, splitting before bin
+		float bestCost = FLT_MAX;
+		int32 bestBin = 0;
+		int32 leftCount = 0;
+		b2AABB leftAABB = node->aabb;
+		for (int32 bin = 1; bin < b2_staticBinCount; ++bin)
+		{
+			if (binCounts[bin - 1] > 0)
+			{
+				if (leftCount == 0)
+				{
+					leftAABB = binAABBs[bin - 1];
+				}
+				else
+				{
+					leftAABB.Combine(binAABBs[bin - 1]);
+				}
+				leftCount += binCounts[bin - 1];
+			}
+
+			if (leftCount == 0 || leftCount == count)
+			{
+				continue;
+			}
+
+			float cost = leftCount * leftAABB.GetPerimeter() + rightCosts[bin];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestBin = bin;
+			}
+		}
+
+		// Keep a leaf if testing its proxies is cheaper than one more node and the halves
+		bestCost = b2_staticTraversalCost + bestCost / node->aabb.GetPerimeter();
+		if (bestBin > 0 && (count > b2_staticLeafSize || bestCost < (float)count))
+		{
+			int32 i = 0;
+			int32 j = count - 1;
+			while (i <= j)
+			{
+				int32 bin = b2Min(int32((leaves[i].aabb.GetCenter()(axis) - lower) * scale), b2_staticBinCount - 1);
+				if (bin < bestBin)
+				{
+					++i;
+				}
+				else
+				{
+					b2StaticLeaf swap = leaves[i];
+					leaves[i] = leaves[j];
+					leaves[j] = swap;
+					--j;
+				}
+			}
+			split = i;
+		}
+	}
+	else if (count > b2_staticLeafSize)
+	{
+		// Every center in the same place, any split is as good
+		split = count / 2;
+	}
+
+	if (split == 0)
+	{
+		node->index = first;
+		node->count = count;
+		return nodeId;
+	}
+
+	node->count = 0;
+	BuildNode(first, split);
+	node->index = BuildNode(first + split, count - split);
+	return nodeId;
+}
+
+int32 b2StaticTree::GetHeight() const
+{
+	if (m_dirty || m_nodeCount == 0)
+	{
+		return 0;
+	}
+
+	return ComputeHeight(0);
+}
+
+int32 b2StaticTree::ComputeHeight(int32 nodeId) const
+{
+	const b2StaticNode* node = m_nodes + nodeId;
+	if (node->count > 0)
+	{
+		return 0;
+	}
+
+	int32 height1 = ComputeHeight(nodeId + 1);
+	int32 height2 = ComputeHeight(node->index);
+	return 1 + b2Max(height1, height2);
+}
+
+void b2StaticTree::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		m_proxies[i].aabb.lowerBound -= newOrigin;
+		m_proxies[i].aabb.upperBound -= newOrigin;
+	}
+
+	for (int32 i = 0; i < m_leafCount; ++i)
+	{
+		m_leaves[i].aabb.lowerBound -= newOrigin;
+		m_leaves[i].aabb.upperBound -= newOrigin;
+	}
+
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		m_nodes[i].aabb.lowerBound -= newOrigin;
+		m_nodes[i].aabb.upperBound -= newOrigin;
+	}
+}
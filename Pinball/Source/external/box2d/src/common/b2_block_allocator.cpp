@@ -30,22 +30,26 @@ static const int32 b2_maxBlockSize = 640;
 static const int32 b2_chunkArrayIncrement = 128;
 
 // These are the supported object sizes. Actual allocations are rounded up the next size.
+// 216 is the contact on 64-bit builds, contacts come and go every step and would waste
+// 8 bytes each in the next size up. 80 is the fixture, which saves 16 bytes per fixture.
 static const int32 b2_blockSizes[b2_blockSizeCount] =
 {
 	16,		// 0
 	32,		// 1
 	64,		// 2
-	96,		// 3
-	128,	// 4
-	160,	// 5
-	192,	// 6
-	224,	// 7
-	256,	// 8
-	320,	// 9
-	384,	// 10
-	448,	// 11
-	512,	// 12
-	640,	// 13
+	80,		// 3
+	96,		// 4
+	128,	// 5
+	160,	// 6
+	192,	// 7
+	216,	// 8
+	224,	// 9
+	256,	// 10
+	320,	// 11
+	384,	// 12
+	448,	// 13
+	512,	// 14
+	640,	// 15
 };
 
 // This maps an arbitrary allocation size to a suitable slot in b2_blockSizes.
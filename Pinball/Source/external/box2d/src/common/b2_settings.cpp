@@ -26,12 +26,16 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <atomic>
 
 b2Version b2_version = {2, 4, 0};
 
+static std::atomic<int32> b2_allocCount(0);
+
 // Memory allocators. Modify these to use your own allocator.
 void* b2Alloc_Default(int32 size)
 {
+	b2_allocCount.fetch_add(1, std::memory_order_relaxed);
 	return malloc(size);
 }
 
@@ -40,6 +44,11 @@ void b2Free_Default(void* mem)
 	free(mem);
 }
 
+int32 b2GetAllocCount()
+{
+	return b2_allocCount.load(std::memory_order_relaxed);
+}
+
 // You can modify this to use your logging facility.
 void b2Log_Default(const char* string, va_list args)
 {
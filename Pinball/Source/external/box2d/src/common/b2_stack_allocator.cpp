@@ -28,6 +28,7 @@ b2StackAllocator::b2StackAllocator()
 	m_index = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_heapCount = 0;
 	m_entryCount = 0;
 }
 
@@ -47,6 +48,7 @@ void* b2StackAllocator::Allocate(int32 size)
 	{
 		entry->data = (char*)b2Alloc(size);
 		entry->usedMalloc = true;
+		++m_heapCount;
 	}
 	else
 	{
@@ -85,3 +87,8 @@ int32 b2StackAllocator::GetMaxAllocation() const
 {
 	return m_maxAllocation;
 }
+
+int32 b2StackAllocator::GetHeapCount() const
+{
+	return m_heapCount;
+}
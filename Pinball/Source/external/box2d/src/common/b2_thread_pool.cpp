@@ -0,0 +1,201 @@
+#include "b2_thread_pool.h"
+
+#include "box2d/b2_math.h"
+
+b2ThreadPool::b2ThreadPool()
+{
+	m_workerCount = 1;
+	m_slices = nullptr;
+	m_task = nullptr;
+	m_context = nullptr;
+	m_remaining = 0;
+	m_active = 0;
+	m_generation = 0;
+	m_quit = false;
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+	Stop();
+}
+
+void b2ThreadPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+
+	delete[] m_slices;
+	m_slices = nullptr;
+	m_workerCount = 1;
+}
+
+void b2ThreadPool::SetWorkerCount(int32 count)
+{
+	count = b2Max(count, 1);
+	if (count == m_workerCount)
+	{
+		return;
+	}
+
+	Stop();
+
+	m_quit = false;
+	m_workerCount = count;
+	m_slices = new std::atomic<uint64_t>[count];
+	for (int32 i = 0; i < count; ++i)
+	{
+		m_slices[i] = 0;
+	}
+
+	for (int32 i = 1; i < count; ++i)
+	{
+		m_threads.push_back(std::thread(&b2ThreadPool::WorkerMain, this, i));
+	}
+}
+
+void b2ThreadPool::Run(int32 count, b2TaskFcn* task, void* context)
+{
+	if (m_workerCount == 1 || count <= 1)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			task(i, 0, context);
+		}
+		return;
+	}
+
+	m_task = task;
+	m_context = context;
+	m_remaining = count;
+
+	// Contiguous slices keep neighbouring islands on one thread
+	for (int32 i = 0; i < m_workerCount; ++i)
+	{
+		uint32 begin = (uint32)((int64_t)count * i / m_workerCount);
+		uint32 end = (uint32)((int64_t)count * (i + 1) / m_workerCount);
+		m_slices[i] = Pack(begin, end);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	Work(0);
+
+	// A worker still looking for work could pick up the next Run's slices with this one's task
+	while (m_remaining > 0 || m_active > 0)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void b2ThreadPool::WorkerMain(int32 worker)
+{
+	uint32 generation = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_quit || m_generation != generation; });
+			if (m_quit)
+			{
+				return;
+			}
+
+			generation = m_generation;
+			++m_active;
+		}
+
+		Work(worker);
+		--m_active;
+	}
+}
+
+void b2ThreadPool::Work(int32 worker)
+{
+	for (;;)
+	{
+		int32 index;
+		while (Pop(worker, &index))
+		{
+			m_task(index, worker, m_context);
+			--m_remaining;
+		}
+
+		if (m_remaining == 0 || Steal(worker) == false)
+		{
+			return;
+		}
+	}
+}
+
+bool b2ThreadPool::Pop(int32 worker, int32* index)
+{
+	std::atomic<uint64_t>& slice = m_slices[worker];
+	uint64_t value = slice.load();
+
+	for (;;)
+	{
+		uint32 begin = (uint32)value;
+		uint32 end = (uint32)(value >> 32);
+		if (begin >= end)
+		{
+			return false;
+		}
+
+		if (slice.compare_exchange_weak(value, Pack(begin + 1, end)))
+		{
+			*index = (int32)begin;
+			return true;
+		}
+	}
+}
+
+bool b2ThreadPool::Steal(int32 worker)
+{
+	for (;;)
+	{
+		// The victim is the worker with the most left to do
+		int32 victim = -1;
+		uint32 most = 0;
+		uint64_t value = 0;
+		for (int32 i = 0; i < m_workerCount; ++i)
+		{
+			uint64_t v = m_slices[i].load();
+			uint32 left = (uint32)(v >> 32) - b2Min((uint32)v, (uint32)(v >> 32));
+			if (i != worker && left > most)
+			{
+				victim = i;
+				most = left;
+				value = v;
+			}
+		}
+
+		if (victim < 0)
+		{
+			return false;
+		}
+
+		// Take the back half, the owner keeps popping from the front
+		uint32 begin = (uint32)value;
+		uint32 end = (uint32)(value >> 32);
+		uint32 split = end - (most + 1) / 2;
+		if (m_slices[victim].compare_exchange_strong(value, Pack(begin, split)))
+		{
+			m_slices[worker] = Pack(split, end);
+			return true;
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef B2_THREAD_POOL_H
+#define B2_THREAD_POOL_H
+
+#include "box2d/b2_types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+/// Called once per task index, worker is the thread running it (0 is the thread that called Run).
+typedef void b2TaskFcn(int32 index, int32 worker, void* context);
+
+/// This is an internal class.
+/// Work stealing pool: every worker starts on its own slice of the task indices and takes half of the
+/// largest slice left once its own runs out. Tasks must not depend on the order they run in.
+class b2ThreadPool
+{
+public:
+	b2ThreadPool();
+	~b2ThreadPool();
+
+	/// Total workers, including the calling thread. 1 runs every task inline.
+	void SetWorkerCount(int32 count);
+	int32 GetWorkerCount() const { return m_workerCount; }
+
+	/// Runs task for every index in [0, count) and returns once all of them are done.
+	void Run(int32 count, b2TaskFcn* task, void* context);
+
+private:
+	// A slice is [begin, end) packed in one word, so the owner and the thieves agree through one compare exchange
+	static uint64_t Pack(uint32 begin, uint32 end) { return ((uint64_t)end << 32) | begin; }
+
+	void WorkerMain(int32 worker);
+	void Work(int32 worker);
+	bool Pop(int32 worker, int32* index);
+	bool Steal(int32 worker);
+	void Stop();
+
+	int32 m_workerCount;
+	std::vector<std::thread> m_threads;
+	std::atomic<uint64_t>* m_slices;
+
+	b2TaskFcn* m_task;
+	void* m_context;
+	std::atomic<int32> m_remaining;
+	std::atomic<int32> m_active;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	uint32 m_generation;
+	bool m_quit;
+};
+
+#endif
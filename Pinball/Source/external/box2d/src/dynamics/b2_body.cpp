@@ -150,14 +150,14 @@ void b2Body::SetType(b2BodyType type)
 	}
 	m_contactList = nullptr;
 
-	// Touch the proxies so that new contacts will be created (when appropriate)
-	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
-	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+	// Recreate the proxies in the tree for the new type, new contacts will be created (when appropriate)
+	if (m_flags & e_enabledFlag)
 	{
-		int32 proxyCount = f->m_proxyCount;
-		for (int32 i = 0; i < proxyCount; ++i)
+		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
-			broadPhase->TouchProxy(f->m_proxies[i].proxyId);
+			f->DestroyProxies(broadPhase);
+			f->CreateProxies(broadPhase, m_xf);
 		}
 	}
 }
@@ -26,6 +26,8 @@
 #include "box2d/b2_fixture.h"
 #include "box2d/b2_world_callbacks.h"
 
+#include <string.h>
+
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
 
@@ -33,11 +35,18 @@ b2ContactManager::b2ContactManager()
 {
 	m_contactList = nullptr;
 	m_contactCount = 0;
+	m_contactArray = nullptr;
+	m_contactCapacity = 0;
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = nullptr;
 }
 
+b2ContactManager::~b2ContactManager()
+{
+	b2Free(m_contactArray);
+}
+
 void b2ContactManager::Destroy(b2Contact* c)
 {
 	b2Fixture* fixtureA = c->GetFixtureA();
@@ -98,6 +107,11 @@ void b2ContactManager::Destroy(b2Contact* c)
 		bodyB->m_contactList = c->m_nodeB.next;
 	}
 
+	// Swap remove from the array.
+	b2Contact* last = m_contactArray[m_contactCount - 1];
+	m_contactArray[c->m_managerIndex] = last;
+	last->m_managerIndex = c->m_managerIndex;
+
 	// Call the factory.
 	b2Contact::Destroy(c, m_allocator);
 	--m_contactCount;
@@ -108,10 +122,11 @@ void b2ContactManager::Destroy(b2Contact* c)
 // contact list.
 void b2ContactManager::Collide()
 {
-	// Update awake contacts.
-	b2Contact* c = m_contactList;
-	while (c)
+	// Update awake contacts. Destroying one moves the last contact into its slot, which is visited next.
+	int32 i = 0;
+	while (i < m_contactCount)
 	{
+		b2Contact* c = m_contactArray[i];
 		b2Fixture* fixtureA = c->GetFixtureA();
 		b2Fixture* fixtureB = c->GetFixtureB();
 		int32 indexA = c->GetChildIndexA();
@@ -125,18 +140,14 @@ void b2ContactManager::Collide()
 			// Should these bodies collide?
 			if (bodyB->ShouldCollide(bodyA) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Destroy(c);
 				continue;
 			}
 
 			// Check user filtering.
 			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Destroy(c);
 				continue;
 			}
 
@@ -150,7 +161,7 @@ void b2ContactManager::Collide()
 		// At least one body must be awake and it must be dynamic or kinematic.
 		if (activeA == false && activeB == false)
 		{
-			c = c->GetNext();
+			++i;
 			continue;
 		}
 
@@ -161,15 +172,13 @@ void b2ContactManager::Collide()
 		// Here we destroy contacts that cease to overlap in the broad-phase.
 		if (overlap == false)
 		{
-			b2Contact* cNuke = c;
-			c = cNuke->GetNext();
-			Destroy(cNuke);
+			Destroy(c);
 			continue;
 		}
 
 		// The contact persists.
 		c->Update(m_contactListener);
-		c = c->GetNext();
+		++i;
 	}
 }
 
@@ -263,6 +272,21 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 	m_contactList = c;
 
+	// Append to the array.
+	if (m_contactCount == m_contactCapacity)
+	{
+		m_contactCapacity = b2Max(2 * m_contactCapacity, 64);
+		b2Contact** contacts = (b2Contact**)b2Alloc(m_contactCapacity * sizeof(b2Contact*));
+		if (m_contactCount > 0)
+		{
+			memcpy(contacts, m_contactArray, m_contactCount * sizeof(b2Contact*));
+		}
+		b2Free(m_contactArray);
+		m_contactArray = contacts;
+	}
+	c->m_managerIndex = m_contactCount;
+	m_contactArray[m_contactCount] = c;
+
 	// Connect to island graph.
 
 	// Connect to body A
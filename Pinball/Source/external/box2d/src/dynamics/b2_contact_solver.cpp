@@ -28,6 +28,8 @@
 #include "box2d/b2_stack_allocator.h"
 #include "box2d/b2_world.h"
 
+#include <string.h>
+
 // Solver debugging is normally disabled because the block solver sometimes has to deal with a poorly conditioned effective mass matrix.
 #define B2_DEBUG_SOLVER 0
 
@@ -48,6 +50,79 @@ struct b2ContactPositionConstraint
 	int32 pointCount;
 };
 
+#ifdef B2_SIMD_SOLVER
+// Wide float used by the batched solver. The widest instruction set the compiler targets is picked,
+// the plain array fallback keeps the option usable everywhere.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define B2_SIMD_WIDTH 8
+typedef __m256 b2FloatW;
+static inline b2FloatW b2LoadW(const float* p) { return _mm256_loadu_ps(p); }
+static inline void b2StoreW(float* p, b2FloatW a) { _mm256_storeu_ps(p, a); }
+static inline b2FloatW b2SplatW(float a) { return _mm256_set1_ps(a); }
+static inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm256_add_ps(a, b); }
+static inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm256_sub_ps(a, b); }
+static inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm256_mul_ps(a, b); }
+static inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm256_min_ps(a, b); }
+static inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm256_max_ps(a, b); }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define B2_SIMD_WIDTH 4
+typedef __m128 b2FloatW;
+static inline b2FloatW b2LoadW(const float* p) { return _mm_loadu_ps(p); }
+static inline void b2StoreW(float* p, b2FloatW a) { _mm_storeu_ps(p, a); }
+static inline b2FloatW b2SplatW(float a) { return _mm_set1_ps(a); }
+static inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm_add_ps(a, b); }
+static inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm_sub_ps(a, b); }
+static inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm_mul_ps(a, b); }
+static inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm_min_ps(a, b); }
+static inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm_max_ps(a, b); }
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define B2_SIMD_WIDTH 4
+typedef float32x4_t b2FloatW;
+static inline b2FloatW b2LoadW(const float* p) { return vld1q_f32(p); }
+static inline void b2StoreW(float* p, b2FloatW a) { vst1q_f32(p, a); }
+static inline b2FloatW b2SplatW(float a) { return vdupq_n_f32(a); }
+static inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return vaddq_f32(a, b); }
+static inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return vsubq_f32(a, b); }
+static inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return vmulq_f32(a, b); }
+static inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return vminq_f32(a, b); }
+static inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return vmaxq_f32(a, b); }
+#else
+#define B2_SIMD_WIDTH 4
+struct b2FloatW
+{
+	float x[B2_SIMD_WIDTH];
+};
+static inline b2FloatW b2LoadW(const float* p) { b2FloatW r; for (int32 i = 0; i < B2_SIMD_WIDTH; ++i) r.x[i] = p[i]; return r; }
+static inline void b2StoreW(float* p, b2FloatW a) { for (int32 i = 0; i < B2_SIMD_WIDTH; ++i) p[i] = a.x[i]; }
+static inline b2FloatW b2SplatW(float a) { b2FloatW r; for (int32 i = 0; i < B2_SIMD_WIDTH; ++i) r.x[i] = a; return r; }
+static inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < B2_SIMD_WIDTH; ++i) a.x[i] += b.x[i]; return a; }
+static inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < B2_SIMD_WIDTH; ++i) a.x[i] -= b.x[i]; return a; }
+static inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < B2_SIMD_WIDTH; ++i) a.x[i] *= b.x[i]; return a; }
+static inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < B2_SIMD_WIDTH; ++i) a.x[i] = b2Min(a.x[i], b.x[i]); return a; }
+static inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { for (int32 i = 0; i < B2_SIMD_WIDTH; ++i) a.x[i] = b2Max(a.x[i], b.x[i]); return a; }
+#endif
+
+// One batch of single point constraints, one lane per constraint. Empty lanes are all zero and solve to nothing.
+struct b2ContactConstraintSIMD
+{
+	float normalX[B2_SIMD_WIDTH], normalY[B2_SIMD_WIDTH];
+	float rAX[B2_SIMD_WIDTH], rAY[B2_SIMD_WIDTH];
+	float rBX[B2_SIMD_WIDTH], rBY[B2_SIMD_WIDTH];
+	float invMassA[B2_SIMD_WIDTH], invIA[B2_SIMD_WIDTH];
+	float invMassB[B2_SIMD_WIDTH], invIB[B2_SIMD_WIDTH];
+	float friction[B2_SIMD_WIDTH];
+	float tangentSpeed[B2_SIMD_WIDTH];
+	float normalMass[B2_SIMD_WIDTH];
+	float tangentMass[B2_SIMD_WIDTH];
+	float velocityBias[B2_SIMD_WIDTH];
+	float normalImpulse[B2_SIMD_WIDTH];
+	float tangentImpulse[B2_SIMD_WIDTH];
+};
+#endif
+
 b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 {
 	m_step = def->step;
@@ -58,6 +133,13 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 	m_positions = def->positions;
 	m_velocities = def->velocities;
 	m_contacts = def->contacts;
+#ifdef B2_SIMD_SOLVER
+	m_batches = nullptr;
+	m_batchLanes = nullptr;
+	m_batchCount = 0;
+	m_scalarConstraints = nullptr;
+	m_scalarCount = 0;
+#endif
 
 	// Initialize position independent portions of the constraints.
 	for (int32 i = 0; i < m_count; ++i)
@@ -138,6 +220,15 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 
 b2ContactSolver::~b2ContactSolver()
 {
+#ifdef B2_SIMD_SOLVER
+	// The stack allocator frees in reverse order
+	if (m_batches)
+	{
+		m_allocator->Free(m_batches);
+		m_allocator->Free(m_scalarConstraints);
+		m_allocator->Free(m_batchLanes);
+	}
+#endif
 	m_allocator->Free(m_velocityConstraints);
 	m_allocator->Free(m_positionConstraints);
 }
@@ -252,6 +343,11 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			}
 		}
 	}
+
+#ifdef B2_SIMD_SOLVER
+	// Point counts are final only now, the block solver setup may drop one
+	BuildBatches();
+#endif
 }
 
 void b2ContactSolver::WarmStart()
@@ -296,9 +392,20 @@ void b2ContactSolver::WarmStart()
 
 void b2ContactSolver::SolveVelocityConstraints()
 {
+#ifdef B2_SIMD_SOLVER
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		SolveBatch(m_batches + i, m_batchLanes + i * B2_SIMD_WIDTH);
+	}
+
+	for (int32 k = 0; k < m_scalarCount; ++k)
+	{
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + m_scalarConstraints[k];
+#else
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+#endif
 
 		int32 indexA = vc->indexA;
 		int32 indexB = vc->indexB;
@@ -606,6 +713,235 @@ void b2ContactSolver::SolveVelocityConstraints()
 	}
 }
 
+#ifdef B2_SIMD_SOLVER
+// Greedy coloring: a constraint goes in the first open batch after every batch already holding one of its bodies,
+// so each body still sees its constraints in the scalar order. Bodies that cannot move may be shared by a batch.
+void b2ContactSolver::BuildBatches()
+{
+	int32 bodyCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		bodyCount = b2Max(bodyCount, b2Max(m_velocityConstraints[i].indexA, m_velocityConstraints[i].indexB) + 1);
+	}
+
+	m_batchLanes = (int32*)m_allocator->Allocate(b2Max(m_count, 1) * B2_SIMD_WIDTH * sizeof(int32));
+	m_scalarConstraints = (int32*)m_allocator->Allocate(b2Max(m_count, 1) * sizeof(int32));
+	int32* lastBatch = (int32*)m_allocator->Allocate(b2Max(bodyCount, 1) * sizeof(int32));
+	int32* fill = (int32*)m_allocator->Allocate(b2Max(m_count, 1) * sizeof(int32));
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		lastBatch[i] = -1;
+	}
+
+	int32 firstOpen = 0;
+	m_batchCount = 0;
+	m_scalarCount = 0;
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		if (vc->pointCount != 1)
+		{
+			m_scalarConstraints[m_scalarCount++] = i;
+			continue;
+		}
+
+		bool movesA = vc->invMassA > 0.0f || vc->invIA > 0.0f;
+		bool movesB = vc->invMassB > 0.0f || vc->invIB > 0.0f;
+
+		int32 batch = firstOpen;
+		if (movesA) batch = b2Max(batch, lastBatch[vc->indexA] + 1);
+		if (movesB) batch = b2Max(batch, lastBatch[vc->indexB] + 1);
+
+		while (batch < m_batchCount && fill[batch] == B2_SIMD_WIDTH)
+		{
+			++batch;
+		}
+
+		if (batch == m_batchCount)
+		{
+			fill[m_batchCount] = 0;
+			for (int32 j = 0; j < B2_SIMD_WIDTH; ++j)
+			{
+				m_batchLanes[m_batchCount * B2_SIMD_WIDTH + j] = -1;
+			}
+			++m_batchCount;
+		}
+
+		m_batchLanes[batch * B2_SIMD_WIDTH + fill[batch]++] = i;
+		if (movesA) lastBatch[vc->indexA] = batch;
+		if (movesB) lastBatch[vc->indexB] = batch;
+
+		while (firstOpen < m_batchCount && fill[firstOpen] == B2_SIMD_WIDTH)
+		{
+			++firstOpen;
+		}
+	}
+
+	m_allocator->Free(fill);
+	m_allocator->Free(lastBatch);
+
+	m_batches = (b2ContactConstraintSIMD*)m_allocator->Allocate(b2Max(m_batchCount, 1) * sizeof(b2ContactConstraintSIMD));
+	memset(m_batches, 0, b2Max(m_batchCount, 1) * sizeof(b2ContactConstraintSIMD));
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2ContactConstraintSIMD* batch = m_batches + i;
+		for (int32 j = 0; j < B2_SIMD_WIDTH; ++j)
+		{
+			int32 index = m_batchLanes[i * B2_SIMD_WIDTH + j];
+			if (index < 0)
+			{
+				continue;
+			}
+
+			const b2ContactVelocityConstraint* vc = m_velocityConstraints + index;
+			const b2VelocityConstraintPoint* vcp = vc->points;
+			batch->normalX[j] = vc->normal.x;
+			batch->normalY[j] = vc->normal.y;
+			batch->rAX[j] = vcp->rA.x;
+			batch->rAY[j] = vcp->rA.y;
+			batch->rBX[j] = vcp->rB.x;
+			batch->rBY[j] = vcp->rB.y;
+			batch->invMassA[j] = vc->invMassA;
+			batch->invIA[j] = vc->invIA;
+			batch->invMassB[j] = vc->invMassB;
+			batch->invIB[j] = vc->invIB;
+			batch->friction[j] = vc->friction;
+			batch->tangentSpeed[j] = vc->tangentSpeed;
+			batch->normalMass[j] = vcp->normalMass;
+			batch->tangentMass[j] = vcp->tangentMass;
+			batch->velocityBias[j] = vcp->velocityBias;
+			batch->normalImpulse[j] = vcp->normalImpulse;
+			batch->tangentImpulse[j] = vcp->tangentImpulse;
+		}
+	}
+}
+
+// Same steps as the scalar single point solve, one constraint per lane. Velocities are gathered per pass,
+// the impulses stay in the batch and are copied back for StoreImpulses and the post solve report.
+void b2ContactSolver::SolveBatch(b2ContactConstraintSIMD* b, const int32* lanes)
+{
+	float vAX[B2_SIMD_WIDTH], vAY[B2_SIMD_WIDTH], wA[B2_SIMD_WIDTH];
+	float vBX[B2_SIMD_WIDTH], vBY[B2_SIMD_WIDTH], wB[B2_SIMD_WIDTH];
+
+	for (int32 j = 0; j < B2_SIMD_WIDTH; ++j)
+	{
+		if (lanes[j] < 0)
+		{
+			vAX[j] = vAY[j] = wA[j] = vBX[j] = vBY[j] = wB[j] = 0.0f;
+			continue;
+		}
+
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + lanes[j];
+		const b2Velocity& velocityA = m_velocities[vc->indexA];
+		const b2Velocity& velocityB = m_velocities[vc->indexB];
+		vAX[j] = velocityA.v.x;
+		vAY[j] = velocityA.v.y;
+		wA[j] = velocityA.w;
+		vBX[j] = velocityB.v.x;
+		vBY[j] = velocityB.v.y;
+		wB[j] = velocityB.w;
+	}
+
+	b2FloatW vax = b2LoadW(vAX), vay = b2LoadW(vAY), wa = b2LoadW(wA);
+	b2FloatW vbx = b2LoadW(vBX), vby = b2LoadW(vBY), wb = b2LoadW(wB);
+
+	b2FloatW nx = b2LoadW(b->normalX), ny = b2LoadW(b->normalY);
+	b2FloatW rax = b2LoadW(b->rAX), ray = b2LoadW(b->rAY);
+	b2FloatW rbx = b2LoadW(b->rBX), rby = b2LoadW(b->rBY);
+	b2FloatW mA = b2LoadW(b->invMassA), iA = b2LoadW(b->invIA);
+	b2FloatW mB = b2LoadW(b->invMassB), iB = b2LoadW(b->invIB);
+	b2FloatW zero = b2SplatW(0.0f);
+
+	// Tangent is b2Cross(normal, 1)
+	b2FloatW tx = ny;
+	b2FloatW ty = b2SubW(zero, nx);
+
+	{
+		// Relative velocity at contact
+		b2FloatW dvx = b2AddW(b2SubW(b2SubW(vbx, b2MulW(wb, rby)), vax), b2MulW(wa, ray));
+		b2FloatW dvy = b2SubW(b2SubW(b2AddW(vby, b2MulW(wb, rbx)), vay), b2MulW(wa, rax));
+
+		// Compute tangent force
+		b2FloatW vt = b2SubW(b2AddW(b2MulW(dvx, tx), b2MulW(dvy, ty)), b2LoadW(b->tangentSpeed));
+		b2FloatW lambda = b2MulW(b2LoadW(b->tangentMass), b2SubW(zero, vt));
+
+		// Clamp the accumulated force
+		b2FloatW oldImpulse = b2LoadW(b->tangentImpulse);
+		b2FloatW maxFriction = b2MulW(b2LoadW(b->friction), b2LoadW(b->normalImpulse));
+		b2FloatW newImpulse = b2MaxW(b2SubW(zero, maxFriction), b2MinW(b2AddW(oldImpulse, lambda), maxFriction));
+		lambda = b2SubW(newImpulse, oldImpulse);
+		b2StoreW(b->tangentImpulse, newImpulse);
+
+		// Apply contact impulse
+		b2FloatW px = b2MulW(lambda, tx);
+		b2FloatW py = b2MulW(lambda, ty);
+
+		vax = b2SubW(vax, b2MulW(mA, px));
+		vay = b2SubW(vay, b2MulW(mA, py));
+		wa = b2SubW(wa, b2MulW(iA, b2SubW(b2MulW(rax, py), b2MulW(ray, px))));
+
+		vbx = b2AddW(vbx, b2MulW(mB, px));
+		vby = b2AddW(vby, b2MulW(mB, py));
+		wb = b2AddW(wb, b2MulW(iB, b2SubW(b2MulW(rbx, py), b2MulW(rby, px))));
+	}
+
+	{
+		// Relative velocity at contact
+		b2FloatW dvx = b2AddW(b2SubW(b2SubW(vbx, b2MulW(wb, rby)), vax), b2MulW(wa, ray));
+		b2FloatW dvy = b2SubW(b2SubW(b2AddW(vby, b2MulW(wb, rbx)), vay), b2MulW(wa, rax));
+
+		// Compute normal impulse
+		b2FloatW vn = b2AddW(b2MulW(dvx, nx), b2MulW(dvy, ny));
+		b2FloatW lambda = b2MulW(b2LoadW(b->normalMass), b2SubW(b2LoadW(b->velocityBias), vn));
+
+		// Clamp the accumulated impulse
+		b2FloatW oldImpulse = b2LoadW(b->normalImpulse);
+		b2FloatW newImpulse = b2MaxW(b2AddW(oldImpulse, lambda), zero);
+		lambda = b2SubW(newImpulse, oldImpulse);
+		b2StoreW(b->normalImpulse, newImpulse);
+
+		// Apply contact impulse
+		b2FloatW px = b2MulW(lambda, nx);
+		b2FloatW py = b2MulW(lambda, ny);
+
+		vax = b2SubW(vax, b2MulW(mA, px));
+		vay = b2SubW(vay, b2MulW(mA, py));
+		wa = b2SubW(wa, b2MulW(iA, b2SubW(b2MulW(rax, py), b2MulW(ray, px))));
+
+		vbx = b2AddW(vbx, b2MulW(mB, px));
+		vby = b2AddW(vby, b2MulW(mB, py));
+		wb = b2AddW(wb, b2MulW(iB, b2SubW(b2MulW(rbx, py), b2MulW(rby, px))));
+	}
+
+	b2StoreW(vAX, vax);
+	b2StoreW(vAY, vay);
+	b2StoreW(wA, wa);
+	b2StoreW(vBX, vbx);
+	b2StoreW(vBY, vby);
+	b2StoreW(wB, wb);
+
+	// Scatter, lanes of one batch never write the same moving body
+	for (int32 j = 0; j < B2_SIMD_WIDTH; ++j)
+	{
+		if (lanes[j] < 0)
+		{
+			continue;
+		}
+
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + lanes[j];
+		m_velocities[vc->indexA].v.Set(vAX[j], vAY[j]);
+		m_velocities[vc->indexA].w = wA[j];
+		m_velocities[vc->indexB].v.Set(vBX[j], vBY[j]);
+		m_velocities[vc->indexB].w = wB[j];
+		vc->points[0].normalImpulse = b->normalImpulse[j];
+		vc->points[0].tangentImpulse = b->tangentImpulse[j];
+	}
+}
+#endif
+
 void b2ContactSolver::StoreImpulses()
 {
 	for (int32 i = 0; i < m_count; ++i)
@@ -31,6 +31,9 @@ class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+#ifdef B2_SIMD_SOLVER
+struct b2ContactConstraintSIMD;
+#endif
 
 struct b2VelocityConstraintPoint
 {
@@ -94,6 +97,19 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+
+#ifdef B2_SIMD_SOLVER
+	// Single point constraints gathered into batches that share no dynamic body, solved one batch per SIMD pass.
+	// The rest (two point manifolds) go through the scalar solver.
+	void BuildBatches();
+	void SolveBatch(b2ContactConstraintSIMD* batch, const int32* lanes);
+
+	b2ContactConstraintSIMD* m_batches;
+	int32* m_batchLanes;
+	int32 m_batchCount;
+	int32* m_scalarConstraints;
+	int32 m_scalarCount;
+#endif
 };
 
 #endif
@@ -32,6 +32,7 @@ class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
 struct b2ContactVelocityConstraint;
+struct b2ContactImpulse;
 struct b2Profile;
 
 /// This is an internal class.
@@ -45,6 +46,7 @@ public:
 	void Clear()
 	{
 		m_bodyCount = 0;
+		m_staticCount = 0;
 		m_contactCount = 0;
 		m_jointCount = 0;
 	}
@@ -61,6 +63,16 @@ public:
 		++m_bodyCount;
 	}
 
+	/// Static body shared with islands solved at the same time, its island index is set by the world.
+	/// These go first, before any other body.
+	void AddStatic(b2Body* body)
+	{
+		b2Assert(m_bodyCount == m_staticCount && body->m_islandIndex == m_staticCount);
+		m_bodies[m_bodyCount] = body;
+		++m_bodyCount;
+		++m_staticCount;
+	}
+
 	void Add(b2Contact* contact)
 	{
 		b2Assert(m_contactCount < m_contactCapacity);
@@ -78,6 +90,9 @@ public:
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
 
+	// When set, Report() fills this instead of calling the listener, so the world can report from one thread
+	b2ContactImpulse* m_impulses;
+
 	b2Body** m_bodies;
 	b2Contact** m_contacts;
 	b2Joint** m_joints;
@@ -86,6 +101,7 @@ public:
 	b2Velocity* m_velocities;
 
 	int32 m_bodyCount;
+	int32 m_staticCount;	// Leading bodies that are only read, they are not written back
 	int32 m_jointCount;
 	int32 m_contactCount;
 
@@ -22,6 +22,7 @@
 
 #include "b2_contact_solver.h"
 #include "b2_island.h"
+#include "common/b2_thread_pool.h"
 
 #include "box2d/b2_body.h"
 #include "box2d/b2_broad_phase.h"
@@ -48,6 +49,9 @@ b2World::b2World(const b2Vec2& gravity)
 	m_bodyList = nullptr;
 	m_jointList = nullptr;
 
+	m_bodyArray = nullptr;
+	m_bodyCapacity = 0;
+
 	m_bodyCount = 0;
 	m_jointCount = 0;
 
@@ -68,6 +72,10 @@ b2World::b2World(const b2Vec2& gravity)
 
 	m_contactManager.m_allocator = &m_blockAllocator;
 
+	m_threadPool = nullptr;
+	m_workerAllocators = nullptr;
+	m_stepAllocations = 0;
+
 	memset(&m_profile, 0, sizeof(b2Profile));
 }
 
@@ -90,6 +98,55 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	SetWorkerCount(1);
+	b2Free(m_bodyArray);
+}
+
+void b2World::SetWorkerCount(int32 count)
+{
+	b2Assert(IsLocked() == false);
+
+	count = b2Max(count, 1);
+	if (count == GetWorkerCount())
+	{
+		return;
+	}
+
+	if (m_threadPool)
+	{
+		int32 allocatorCount = m_threadPool->GetWorkerCount() - 1;
+		for (int32 i = 0; i < allocatorCount; ++i)
+		{
+			m_workerAllocators[i].~b2StackAllocator();
+		}
+		b2Free(m_workerAllocators);
+		m_workerAllocators = nullptr;
+
+		m_threadPool->~b2ThreadPool();
+		b2Free(m_threadPool);
+		m_threadPool = nullptr;
+	}
+
+	if (count == 1)
+	{
+		return;
+	}
+
+	void* mem = b2Alloc(sizeof(b2ThreadPool));
+	m_threadPool = new (mem) b2ThreadPool;
+	m_threadPool->SetWorkerCount(count);
+
+	m_workerAllocators = (b2StackAllocator*)b2Alloc((count - 1) * sizeof(b2StackAllocator));
+	for (int32 i = 0; i < count - 1; ++i)
+	{
+		new (m_workerAllocators + i) b2StackAllocator;
+	}
+}
+
+int32 b2World::GetWorkerCount() const
+{
+	return m_threadPool ? m_threadPool->GetWorkerCount() : 1;
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -131,6 +188,21 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 		m_bodyList->m_prev = b;
 	}
 	m_bodyList = b;
+
+	// Append to the array.
+	if (m_bodyCount == m_bodyCapacity)
+	{
+		m_bodyCapacity = b2Max(2 * m_bodyCapacity, 16);
+		b2Body** bodies = (b2Body**)b2Alloc(m_bodyCapacity * sizeof(b2Body*));
+		if (m_bodyCount > 0)
+		{
+			memcpy(bodies, m_bodyArray, m_bodyCount * sizeof(b2Body*));
+		}
+		b2Free(m_bodyArray);
+		m_bodyArray = bodies;
+	}
+	b->m_worldIndex = m_bodyCount;
+	m_bodyArray[m_bodyCount] = b;
 	++m_bodyCount;
 
 	return b;
@@ -212,6 +284,11 @@ void b2World::DestroyBody(b2Body* b)
 		m_bodyList = b->m_next;
 	}
 
+	// Swap remove from the array.
+	b2Body* last = m_bodyArray[m_bodyCount - 1];
+	m_bodyArray[b->m_worldIndex] = last;
+	last->m_worldIndex = b->m_worldIndex;
+
 	--m_bodyCount;
 	b->~b2Body();
 	m_blockAllocator.Free(b, sizeof(b2Body));
@@ -397,6 +474,43 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
 
+	if (m_threadPool)
+	{
+		SolveIslandsParallel(step);
+	}
+	else
+	{
+		SolveIslands(step);
+	}
+
+	{
+		b2Timer timer;
+		// Synchronize fixtures, check for out of range bodies.
+		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		{
+			// If a body was not in an island then it did not move.
+			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			{
+				continue;
+			}
+
+			if (b->GetType() == b2_staticBody)
+			{
+				continue;
+			}
+
+			// Update fixtures (for broad-phase).
+			b->SynchronizeFixtures();
+		}
+
+		// Look for new contacts.
+		m_contactManager.FindNewContacts();
+		m_profile.broadphase = timer.GetMilliseconds();
+	}
+}
+
+void b2World::SolveIslands(const b2TimeStep& step)
+{
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
@@ -405,13 +519,13 @@ void b2World::Solve(const b2TimeStep& step)
 					m_contactManager.m_contactListener);
 
 	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b->m_flags &= ~b2Body::e_islandFlag;
+		m_bodyArray[i]->m_flags &= ~b2Body::e_islandFlag;
 	}
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
 	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
+		m_contactManager.m_contactArray[i]->m_flags &= ~b2Contact::e_islandFlag;
 	}
 	for (b2Joint* j = m_jointList; j; j = j->m_next)
 	{
@@ -554,31 +668,269 @@ void b2World::Solve(const b2TimeStep& step)
 	}
 
 	m_stackAllocator.Free(stack);
+}
+
+// One island of a parallel solve, a range of the bodies, contacts and joints gathered for the step
+struct b2IslandTask
+{
+	int32 bodyStart, bodyCount;
+	int32 contactStart, contactCount;
+	int32 jointStart, jointCount;
+	b2Profile profile;
+};
+
+struct b2IslandTaskContext
+{
+	b2IslandTask* islands;
+	b2Body** bodies;
+	b2Contact** contacts;
+	b2Joint** joints;
+	b2Body** statics;
+	int32 staticCount;
+	b2ContactImpulse* impulses;
+	b2StackAllocator** allocators;
+	b2TimeStep step;
+	b2Vec2 gravity;
+	bool allowSleep;
+};
 
+static void b2SolveIslandTask(int32 index, int32 worker, void* context)
+{
+	b2IslandTaskContext* c = (b2IslandTaskContext*)context;
+	b2IslandTask* task = c->islands + index;
+
+	b2Island island(c->staticCount + task->bodyCount, task->contactCount, task->jointCount, c->allocators[worker], nullptr);
+
+	for (int32 i = 0; i < c->staticCount; ++i)
 	{
-		b2Timer timer;
-		// Synchronize fixtures, check for out of range bodies.
-		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		island.AddStatic(c->statics[i]);
+	}
+	for (int32 i = 0; i < task->bodyCount; ++i)
+	{
+		island.Add(c->bodies[task->bodyStart + i]);
+	}
+	for (int32 i = 0; i < task->contactCount; ++i)
+	{
+		island.Add(c->contacts[task->contactStart + i]);
+	}
+	for (int32 i = 0; i < task->jointCount; ++i)
+	{
+		island.Add(c->joints[task->jointStart + i]);
+	}
+
+	island.m_impulses = c->impulses + task->contactStart;
+	island.Solve(&task->profile, c->step, c->gravity, c->allowSleep);
+}
+
+// Same islands as SolveIslands(), all of them are built first and then solved on the thread pool.
+// Islands share nothing but static bodies, those get one index for the whole step and are only read,
+// so every island ends the same as when solved alone. Post solve is reported afterwards, in island order.
+void b2World::SolveIslandsParallel(const b2TimeStep& step)
+{
+	// Clear all the island flags.
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodyArray[i];
+		b->m_flags &= ~b2Body::e_islandFlag;
+		if (b->GetType() == b2_staticBody)
 		{
-			// If a body was not in an island then it did not move.
-			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			b->m_islandIndex = -1;
+		}
+	}
+	for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
+	{
+		m_contactManager.m_contactArray[i]->m_flags &= ~b2Contact::e_islandFlag;
+	}
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->m_islandFlag = false;
+	}
+
+	b2IslandTaskContext context;
+	context.islands = (b2IslandTask*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandTask));
+	context.bodies = (b2Body**)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2Body*));
+	context.statics = (b2Body**)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2Body*));
+	context.contacts = (b2Contact**)m_stackAllocator.Allocate(m_contactManager.m_contactCount * sizeof(b2Contact*));
+	context.joints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+	context.staticCount = 0;
+	context.step = step;
+	context.gravity = m_gravity;
+	context.allowSleep = m_allowSleep;
+
+	int32 islandCount = 0;
+	int32 bodyCount = 0;
+	int32 contactCount = 0;
+	int32 jointCount = 0;
+
+	// Build all awake islands.
+	int32 stackSize = m_bodyCount;
+	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	{
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
+		}
+
+		if (seed->IsAwake() == false || seed->IsEnabled() == false)
+		{
+			continue;
+		}
+
+		// The seed can be dynamic or kinematic.
+		if (seed->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		b2IslandTask* island = context.islands + islandCount++;
+		island->bodyStart = bodyCount;
+		island->contactStart = contactCount;
+		island->jointStart = jointCount;
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		seed->m_flags |= b2Body::e_islandFlag;
+
+		// Perform a depth first search (DFS) on the constraint graph.
+		while (stackCount > 0)
+		{
+			b2Body* b = stack[--stackCount];
+			b2Assert(b->IsEnabled() == true);
+
+			// Static bodies join every island that touches them and are not propagated across.
+			// Their flag is cleared right away so the next islands can reach them too.
+			if (b->GetType() == b2_staticBody)
 			{
+				b->m_flags &= ~b2Body::e_islandFlag;
+				if (b->m_islandIndex < 0)
+				{
+					b->m_islandIndex = context.staticCount;
+					context.statics[context.staticCount++] = b;
+				}
 				continue;
 			}
 
-			if (b->GetType() == b2_staticBody)
+			context.bodies[bodyCount++] = b;
+
+			// Make sure the body is awake (without resetting sleep timer).
+			b->m_flags |= b2Body::e_awakeFlag;
+
+			// Search all contacts connected to this body.
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
 			{
-				continue;
+				b2Contact* contact = ce->contact;
+
+				// Has this contact already been added to an island?
+				if (contact->m_flags & b2Contact::e_islandFlag)
+				{
+					continue;
+				}
+
+				// Is this contact solid and touching?
+				if (contact->IsEnabled() == false ||
+					contact->IsTouching() == false)
+				{
+					continue;
+				}
+
+				// Skip sensors.
+				bool sensorA = contact->m_fixtureA->m_isSensor;
+				bool sensorB = contact->m_fixtureB->m_isSensor;
+				if (sensorA || sensorB)
+				{
+					continue;
+				}
+
+				context.contacts[contactCount++] = contact;
+				contact->m_flags |= b2Contact::e_islandFlag;
+
+				b2Body* other = ce->other;
+
+				// Was the other body already added to this island?
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
 			}
 
-			// Update fixtures (for broad-phase).
-			b->SynchronizeFixtures();
+			// Search all joints connect to this body.
+			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			{
+				if (je->joint->m_islandFlag == true)
+				{
+					continue;
+				}
+
+				b2Body* other = je->other;
+
+				// Don't simulate joints connected to diabled bodies.
+				if (other->IsEnabled() == false)
+				{
+					continue;
+				}
+
+				context.joints[jointCount++] = je->joint;
+				je->joint->m_islandFlag = true;
+
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
 		}
 
-		// Look for new contacts.
-		m_contactManager.FindNewContacts();
-		m_profile.broadphase = timer.GetMilliseconds();
+		island->bodyCount = bodyCount - island->bodyStart;
+		island->contactCount = contactCount - island->contactStart;
+		island->jointCount = jointCount - island->jointStart;
+	}
+
+	m_stackAllocator.Free(stack);
+
+	// Worker 0 is this thread, it keeps using the world allocator
+	int32 workerCount = m_threadPool->GetWorkerCount();
+	context.allocators = (b2StackAllocator**)m_stackAllocator.Allocate(workerCount * sizeof(b2StackAllocator*));
+	context.allocators[0] = &m_stackAllocator;
+	for (int32 i = 1; i < workerCount; ++i)
+	{
+		context.allocators[i] = m_workerAllocators + i - 1;
+	}
+	context.impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(contactCount * sizeof(b2ContactImpulse));
+
+	m_threadPool->Run(islandCount, b2SolveIslandTask, &context);
+
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		const b2IslandTask* island = context.islands + i;
+		m_profile.solveInit += island->profile.solveInit;
+		m_profile.solveVelocity += island->profile.solveVelocity;
+		m_profile.solvePosition += island->profile.solvePosition;
+
+		if (listener)
+		{
+			for (int32 j = island->contactStart; j < island->contactStart + island->contactCount; ++j)
+			{
+				listener->PostSolve(context.contacts[j], context.impulses + j);
+			}
+		}
 	}
+
+	m_stackAllocator.Free(context.impulses);
+	m_stackAllocator.Free(context.allocators);
+	m_stackAllocator.Free(context.joints);
+	m_stackAllocator.Free(context.contacts);
+	m_stackAllocator.Free(context.statics);
+	m_stackAllocator.Free(context.bodies);
+	m_stackAllocator.Free(context.islands);
 }
 
 // Find TOI contacts and solve them.
@@ -588,14 +940,17 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 	if (m_stepComplete)
 	{
-		for (b2Body* b = m_bodyList; b; b = b->m_next)
+		for (int32 i = 0; i < m_bodyCount; ++i)
 		{
+			b2Body* b = m_bodyArray[i];
 			b->m_flags &= ~b2Body::e_islandFlag;
 			b->m_sweep.alpha0 = 0.0f;
 		}
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
 		{
+			b2Contact* c = m_contactManager.m_contactArray[i];
+
 			// Invalidate TOI
 			c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
 			c->m_toiCount = 0;
@@ -905,6 +1260,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 void b2World::Step(float dt, int32 velocityIterations, int32 positionIterations)
 {
 	b2Timer stepTimer;
+	int32 allocCount = b2GetAllocCount();
 
 	// If new fixtures were added, we need to find the new contacts.
 	if (m_newContacts)
@@ -968,12 +1324,32 @@ void b2World::Step(float dt, int32 velocityIterations, int32 positionIterations)
 	m_locked = false;
 
 	m_profile.step = stepTimer.GetMilliseconds();
+	m_stepAllocations = b2GetAllocCount() - allocCount;
+}
+
+b2AllocatorStats b2World::GetAllocatorStats() const
+{
+	b2AllocatorStats stats;
+	stats.stepAllocations = m_stepAllocations;
+	stats.blockChunks = m_blockAllocator.GetChunkCount();
+	stats.stackPeak = m_stackAllocator.GetMaxAllocation();
+	stats.stackHeapAllocations = m_stackAllocator.GetHeapCount();
+
+	int32 allocatorCount = GetWorkerCount() - 1;
+	for (int32 i = 0; i < allocatorCount; ++i)
+	{
+		stats.stackPeak = b2Max(stats.stackPeak, m_workerAllocators[i].GetMaxAllocation());
+		stats.stackHeapAllocations += m_workerAllocators[i].GetHeapCount();
+	}
+
+	return stats;
 }
 
 void b2World::ClearForces()
 {
-	for (b2Body* body = m_bodyList; body; body = body->GetNext())
+	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
+		b2Body* body = m_bodyArray[i];
 		body->m_force.SetZero();
 		body->m_torque = 0.0f;
 	}